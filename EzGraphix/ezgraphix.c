@@ -1,376 +1,5766 @@
+#ifndef _WIN32
+// for clock_gettime
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "ezgraphix.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "ezthread.h"
+#include "ezsoftware.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef EZ_HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <time.h>
+#endif
+
+#ifdef _WIN32
 #include <Windows.h>
+#include <direct.h>
 
 // enable optimus!
 // https://stackoverflow.com/questions/6036292/select-a-graphic-device-in-windows-opengl
 _declspec(dllexport) DWORD NvOptimusEnablement = 1;
 _declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
+#else
+#include <sys/stat.h>
+#endif
+
+// these functions must be declared
+int setup(void); // called for setup
+void draw(void); // called every frame
+void cleanup(void); // called at the end to clean up memory used
+
+// Define this to verify the cached uniform locations against the live ones every frame.
+// Enabled by default in debug builds.
+#if defined(_DEBUG) && !defined(EZ_CHECK_UNIFORMS)
+#define EZ_CHECK_UNIFORMS
+#endif
+
+// Define this to ask for an OpenGL debug context, which reports more problems, and to report them synchronously
+// so each one comes with the exact call site. Enabled by default in debug builds.
+#if defined(_DEBUG) && !defined(EZ_GL_DEBUG)
+#define EZ_GL_DEBUG
+#endif
+
+// Uniform locations of a shader program, looked up once when the program is linked
+// rather than by name on every draw call.
+struct EzUniforms {
+	int windowSize;
+	int cameraOffset;
+	int cameraTransform;
+	int textureSampler;
+};
+
+// Last values uploaded to the uniforms of a program, so unchanged values aren't uploaded again
+struct EzUniformValues {
+	float windowSize[2];
+	float cameraOffset[2];
+	float cameraTransform[4];
+	int textureSampler;
+};
+
+// A shader program owned by the library, along with its uniform table
+struct EzProgram {
+	// 0 until it's built
+	unsigned int id;
+	struct EzUniforms uniforms;
+	struct EzUniformValues values;
+};
+
+// Features a shader variant has. A batch uses the variant with every feature any of its objects need.
+#define EZ_VARIANT_TEXTURED 1
+#define EZ_VARIANT_FILLETED 2
+#define EZ_VARIANT_ALL (EZ_VARIANT_TEXTURED | EZ_VARIANT_FILLETED)
+#define EZ_VARIANT_COUNT 4
+
+// Saves linked shader programs to disk, so later runs on the same driver can skip compiling them
+struct EzShaderCache {
+	// NULL if caching is turned off
+	char* directory;
+	// whether the driver has been asked if it can save programs, and its answer
+	int checked;
+	int supported;
+	EZshadercachestats stats;
+};
+
+// Number of texture units tracked by the state cache. OpenGL 3.3 guarantees at least 16.
+#define EZ_TEXTURE_UNITS 16
+
+// Shadow copy of the OpenGL state the library changes, used to skip calls that wouldn't change anything.
+// All binds in the library must go through the ezState functions so this stays in sync.
+struct EzGLState {
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int arrayBuffer;
+	// index of the active texture unit, starting at 0 for GL_TEXTURE0
+	int activeTexture;
+	unsigned int textures[EZ_TEXTURE_UNITS];
+	// whether GL_BLEND is enabled
+	int blend;
+};
+
+// Max number of objects in a single batch
+#define EZ_BATCH_CAPACITY 4096
+// Floats per object instance: position (2), dimensions (2), anchor (2), colour (3), borderWidth (1), textured (1), depth (1), uvRect (4),
+// corner radii (4), border colour (3), rotation (1), scale (2), and two unused to keep instances 16 byte aligned
+#define EZ_INSTANCE_SIZE 28
+// Number of per instance vertex attributes, at locations 1 and up
+#define EZ_INSTANCE_ATTRIBUTES 12
+// Instances are written straight into a ring buffer the GPU reads from. The ring is split into chunks, each fenced
+// once the draws using it are issued, so a chunk is only written again once the GPU has finished with it.
+#define EZ_STREAM_CHUNKS 8
+// Size of each chunk, in full batches
+#define EZ_STREAM_CHUNK_BATCHES 2
+#define EZ_BATCH_BYTES (sizeof(float) * EZ_INSTANCE_SIZE * EZ_BATCH_CAPACITY)
+#define EZ_STREAM_CHUNK_BYTES (EZ_BATCH_BYTES * EZ_STREAM_CHUNK_BATCHES)
+// Number of distinct depths ezDrawMany can give objects each frame, spaced so they stay apart in a 24 bit depth buffer
+#define EZ_DEPTH_LEVELS (1 << 20)
+// Max number of objects ezDrawMany reorders at once
+#define EZ_DRAW_MANY_CHUNK EZ_DEPTH_LEVELS
+
+// Collects the objects drawn during a frame so they can be sent to OpenGL in as few draw calls as possible.
+// Every object is an instance of the same unit quad, scaled and moved in the vertex shader.
+struct EzBatch {
+	// vertex array object holding the whole layout below, so a flush binds it in one call
+	unsigned int vao;
+	// offset in bytes the instance attributes point at in the ring. Only moves without GL_ARB_base_instance.
+	long long pointedOffset;
+	// the shared unit quad
+	unsigned int vbo;
+	unsigned int ibo;
+	// per object data: the streaming ring, EZ_STREAM_CHUNKS * EZ_STREAM_CHUNK_BYTES long
+	unsigned int instanceVbo;
+	// where the batch's instances are written. Points into the ring, or into staging if it couldn't be mapped.
+	float* instances;
+	// the whole ring, if it stays mapped (GL_ARB_buffer_storage). Otherwise each batch maps its own range.
+	unsigned char* persistent;
+	// fallback for when mapping fails, uploaded with glBufferSubData
+	float* staging;
+	// offset in the ring of the batch's first instance, in bytes, and the chunk it's in
+	long long offset;
+	int chunk;
+	// fence after the last draw to read each chunk, or 0 if the GPU isn't using it
+	GLsync fences[EZ_STREAM_CHUNKS];
+	// number of objects in the batch
+	int count;
+	// the OpenGL texture shared by every textured object in the batch. Untextured objects can join any batch.
+	unsigned int texture;
+	// shader features the objects in the batch need, as EZ_VARIANT_* flags
+	int variant;
+	// depth given to new instances. Only used while ezDrawMany has the depth test enabled.
+	float depth;
+	// depth levels ezDrawMany has handed out since the depth buffer was cleared with the screen
+	int depthLevels;
+	// point in the world the positions of new instances are relative to, so they keep their precision far from 0.
+	// Moved to the camera whenever it changes, since the batch is flushed then anyway.
+	double origin[2];
+};
+
+// Where the camera is looking. See ezCameraMove()
+struct EzCamera {
+	// point in the world shown at the bottom left of the window, before zooming and rotating
+	double x;
+	double y;
+	float zoom;
+	// anticlockwise, in radians. Zooming and rotating are both about the centre of the window.
+	float rotation;
+	// of the rotation, worked out when it's set
+	double sine;
+	double cosine;
+	// area of the world it sees, see ezViewBounds, and the window size that was worked out for.
+	// viewWidth is set to -1 when the camera changes.
+	double view[4];
+	int viewWidth;
+	int viewHeight;
+};
+
+// How far the camera can get from the point the scene's instance positions are relative to before they're made
+// relative to the camera instead, in pixels. Floats are precise to 1/128 of a pixel this far out.
+#define EZ_SCENE_REBASE_DISTANCE 65536.0
+
+// Dirty objects closer together than this many instances are uploaded by ezDrawScene in one call,
+// since each call costs more than sending the unchanged instances in between
+#define EZ_SCENE_UPLOAD_GAP 32
+
+// Visible objects of the scene are drawn from its buffer in ranges, joined up across gaps of up to this many entries
+// that are off screen. If the visible objects are spread over more ranges than EZ_SCENE_MAX_RANGES, they're batched instead.
+#define EZ_SCENE_CULL_GAP 64
+#define EZ_SCENE_MAX_RANGES 64
+// Width and height of a cell of a spatial index, in pixels
+#define EZ_GRID_CELL_SIZE 128.0f
+// Objects overlapping more cells than this are kept in a list of their own, which is checked every time
+#define EZ_GRID_MAX_CELLS 64
+// Cell coordinates are clamped to this, so objects far away don't overflow them
+#define EZ_GRID_LIMIT (1 << 24)
+
+// The cells of a grid an entry overlaps, inclusive. x0 > x1 if it isn't in the grid.
+struct EzGridBounds {
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+	// whether it's in the grid's list of large entries rather than in the cells
+	int large;
+};
+
+// A cell of a grid, listing the entries that overlap it
+struct EzGridCell {
+	// whether this slot of the hash table holds a cell
+	int used;
+	int x;
+	int y;
+	int* entries;
+	int count;
+	int capacity;
+};
+
+// Spatial index: a uniform grid, hashed so only cells with something in them take up memory.
+// Entries are numbered by whatever owns the grid: the scene's entries, or the objects drawn in the last frame.
+struct EzGrid {
+	// hash table of cells, with a power of two capacity. Cells stay once made, until the grid is rebuilt.
+	struct EzGridCell* cells;
+	int capacity;
+	int cellCount;
+	// entries overlapping more than EZ_GRID_MAX_CELLS cells
+	struct EzGridCell large;
+	// area covered by everything put in since the grid was rebuilt, left, bottom, right, top, if extents is set
+	int extents;
+	double area[4];
+	// set if an entry couldn't be added for lack of memory, so the grid can't be trusted until it's rebuilt
+	int failed;
+};
+
+// Consecutive objects in the scene that are drawn with a single draw call
+struct EzSceneRun {
+	int first;
+	int count;
+	// as for a batch: the texture of its textured objects, and the shader features its objects need
+	unsigned int texture;
+	int variant;
+};
+
+// The objects drawn by ezDrawScene. Their instance data stays in a buffer of its own between frames,
+// and only the instances of objects that have changed since the last draw are uploaded again.
+struct EzScene {
+	// pool slot of each object in draw order, or -1 where an object has been removed
+	int* slots;
+	int count;
+	int capacity;
+	// number of -1 entries in slots. Taken out once they are half of the scene.
+	int removed;
+	// copy of the instance data in the buffer, EZ_INSTANCE_SIZE floats per entry
+	float* instances;
+	unsigned int vbo;
+	// the same layout as the batch's vertex array, reading instances from the scene's buffer instead
+	unsigned int vao;
+	long long pointedOffset;
+	// number of entries the buffer has room for
+	int bufferCapacity;
+	// entries changed since the last ezDrawScene, each listed once, and which entries are in the list
+	int* dirty;
+	int dirtyCount;
+	unsigned char* dirtyFlags;
+	// set when the runs have to be worked out again, after an object's texture or edges change
+	int restructure;
+	// set when every instance has to be uploaded again
+	int uploadAll;
+	// the image table's revision when the instances were last written. Loading images changes their textures.
+	unsigned int imageRevision;
+	struct EzSceneRun* runs;
+	int runCount;
+	int runCapacity;
+	// spatial index of the entries, for culling. Kept up to date from the entries marked dirty,
+	// so moving a few objects only moves those in the grid.
+	struct EzGrid grid;
+	// cells of the grid each entry is in
+	struct EzGridBounds* bounds;
+	// point in the world the positions in the instance buffer are relative to. See EZ_SCENE_REBASE_DISTANCE.
+	double origin[2];
+	// the query each entry was last found by, so entries in several cells are only listed once
+	unsigned int* seen;
+	unsigned int query;
+	// entries found by the last query
+	int* visible;
+	EZscenestats stats;
+};
+
+// An object as it was drawn, for picking
+struct EzPickEntry {
+	EZobject* object;
+	// a rectangle in the world it was inside, from ezObjectRect: left, bottom, right, top
+	double area[4];
+	// its anchor point in the world, and how it was turned and stretched about it
+	double x;
+	double y;
+	float rotation;
+	float scale[2];
+	// the rectangle it filled relative to its anchor point, before it was turned and stretched: left, bottom, right, top
+	float rect[4];
+	// fillet radius of each corner, no more than half the width or height
+	float radii[4];
+	// the camera it was drawn through, from the frame's list
+	int camera;
+};
+
+// Everything drawn in a frame, in order
+struct EzPickFrame {
+	struct EzPickEntry* entries;
+	int count;
+	int capacity;
+	// every camera used, in case it changed partway through, e.g. to draw a HUD
+	struct EzCamera* cameras;
+	int cameraCount;
+	int cameraCapacity;
+};
+
+// Records the objects drawn each frame, so objects under the mouse can be found. See ezPick()
+struct EzPicker {
+	// off until the program first picks something, so programs that don't pick don't pay for recording
+	int enabled;
+	// the frame being drawn
+	struct EzPickFrame drawing;
+	// set if an object couldn't be recorded for lack of memory, so no more are this frame
+	int lost;
+	// the last frame, which is what's on screen
+	struct EzPickFrame drawn;
+	// the last frame's objects by where they are in the window, made the first time they're picked from
+	struct EzGrid grid;
+	int indexed;
+};
+
+// An object in ezDrawMany, along with its place in the original order
+struct EzSortEntry {
+	unsigned int texture;
+	int index;
+	int slot;
+};
+
+// Object handles given to the user pack a pool slot (low bits, offset by 1 so no handle is NULL)
+// together with the generation of the slot (high bits), so handles to deleted objects can be detected.
+// The generation gets the rest of the pointer: 42 bits on 64 bit platforms, 10 on 32 bit ones.
+#define EZ_HANDLE_INDEX_BITS 22
+#define EZ_HANDLE_INDEX_MASK (((uintptr_t)1 << EZ_HANDLE_INDEX_BITS) - 1)
+#define EZ_HANDLE_GENERATION_MASK (UINTPTR_MAX >> EZ_HANDLE_INDEX_BITS)
+// Max number of objects alive at once
+#define EZ_POOL_MAX_OBJECTS ((int)EZ_HANDLE_INDEX_MASK)
+// Number of slots allocated the first time an object is created
+#define EZ_POOL_INITIAL_CAPACITY 256
+// Marks a slot in use in the free list
+#define EZ_SLOT_IN_USE -2
+// Marks a slot whose generation has wrapped around, so it's never reused: a handle from before the wrap would match again
+#define EZ_SLOT_RETIRED -3
+
+// Storage for every object. Each field is kept in its own contiguous array, indexed by slot,
+// so code that walks over many objects only touches the fields it needs.
+struct EzObjectPool {
+	int capacity;
+	// first and last slots of the free list, or -1 if every slot is in use.
+	// Freed slots go on the end, so a slot is reused as late as possible.
+	int freeHead;
+	int freeTail;
+	// Colour
+	float* r;
+	float* g;
+	float* b;
+	// Position. Doubles, so objects far out in a large world are still placed to a fraction of a pixel.
+	double* x;
+	double* y;
+	// Used for the anchor thing. As a proportion of width/height.
+	float* anchorX;
+	float* anchorY;
+	// Dimensions
+	float* width;
+	float* height;
+	// Turned and stretched about the anchor. Rotation is anticlockwise in radians.
+	float* rotation;
+	float* scaleX;
+	float* scaleY;
+	// Fillet radius of each corner: bottom left, bottom right, top right, top left
+	float (*radii)[4];
+	// Border, drawn inside the edge of the object
+	float* borderWidth;
+	float (*borderColour)[3];
+	// Texture
+	int* texture;
+	// position in the scene's draw order, or -1 if not in the scene
+	int* sceneIndex;
+	// incremented whenever the slot is freed, so old handles stop matching
+	uintptr_t* generation;
+	// next slot in the free list, -1 at the end, EZ_SLOT_IN_USE or EZ_SLOT_RETIRED
+	int* nextFree;
+};
+
+// Images up to this size in both dimensions are packed into atlas pages
+#define EZ_ATLAS_MAX_IMAGE_SIZE 512
+// Preferred width and height of an atlas page. Smaller if the GPU doesn't support textures this big.
+#define EZ_ATLAS_PAGE_SIZE 2048
+// Max number of atlas pages. Images that don't fit get their own texture.
+#define EZ_ATLAS_MAX_PAGES 16
+// Gutter around each image in a page, filled by stretching the image's edge pixels.
+// Regions are also aligned to this, so mipmap levels up to EZ_ATLAS_MIP_LEVELS never mix neighbouring images.
+#define EZ_ATLAS_PADDING 4
+#define EZ_ATLAS_MIP_LEVELS 2
+// Every skyline segment is at least EZ_ATLAS_PADDING wide, so this is enough for any page
+#define EZ_ATLAS_MAX_NODES (EZ_ATLAS_PAGE_SIZE / EZ_ATLAS_PADDING + 1)
+
+// A large texture that many small images are packed into.
+// Space is handed out with a skyline packer: the page is filled bottom up, and the skyline records
+// how high the used space reaches across each horizontal span.
+struct EzAtlasPage {
+	unsigned int texture;
+	// skyline segments, left to right
+	int nodeCount;
+	int nodeX[EZ_ATLAS_MAX_NODES];
+	int nodeY[EZ_ATLAS_MAX_NODES];
+	int nodeWidth[EZ_ATLAS_MAX_NODES];
+	// number of live images in the page. Once it drops to 0 the whole page is reused.
+	int images;
+	long long usedPixels;
+	long long paddingPixels;
+	long long wastedPixels;
+	// set when images have been added since the mipmaps were last generated
+	int mipmapsDirty;
+};
+
+// An image loaded by the user
+struct EzImage {
+	int inUse;
+	// the OpenGL texture holding the image: its own texture, an atlas page, or the white placeholder
+	unsigned int texture;
+	// atlas page holding the image, or -1
+	int page;
+	// area of the texture covered by the image: u0, v0, u1, v1
+	float uvRect[4];
+	int width;
+	int height;
+	// size of the region reserved in the atlas page, including padding
+	int regionWidth;
+	int regionHeight;
+	// cache key: the file the image was loaded from, and a hash and size of its contents
+	char* path;
+	unsigned long long hash;
+	long long fileSize;
+	// number of ezLoadImage calls not yet matched by ezFreeImage. Unreferenced images may stay cached.
+	int refCount;
+	// set while the image is being loaded in the background
+	int loading;
+	// GPU memory held by the image, 0 if it didn't load
+	long long bytes;
+	// copy of the image and its mipmaps for the software renderer, or NULL
+	unsigned char* pixels;
+	int pixelLevels;
+	// value of the table's tick when the image was last loaded or freed, for LRU eviction
+	unsigned long long lastUsed;
+	// value of the table's revision when the image's texture or place in it last changed. Kept after it's freed.
+	unsigned int revision;
+};
+
+// Every image the user has loaded, indexed by image id - 1
+struct EzImageTable {
+	struct EzImage* images;
+	int capacity;
+	// drawn in place of images that are still loading
+	unsigned int whiteTexture;
+	int atlasEnabled;
+	// whether to keep a copy of each image in memory for the software renderer
+	int keepPixels;
+	int pageSize;
+	int pageCount;
+	// whether any page has mipmapsDirty set
+	int mipmapsDirty;
+	// changed whenever an image's texture or place in it changes, so drawing that kept the old ones knows to update
+	unsigned int revision;
+	struct EzAtlasPage pages[EZ_ATLAS_MAX_PAGES];
+	// GPU memory unreferenced images may keep using before they're evicted. 0 to free them straight away.
+	long long memoryBudget;
+	long long residentBytes;
+	unsigned long long tick;
+	int hits;
+	int misses;
+	int evictions;
+};
+
+// Max number of threads decoding images in the background
+#define EZ_MAX_IMAGE_WORKERS 4
+// Default time each frame may spend uploading background-loaded images, in milliseconds
+#define EZ_DEFAULT_IMAGE_UPLOAD_BUDGET 2.0
+
+// An image being loaded in the background
+struct EzImageJob {
+	char* fileName;
+	// the image being loaded
+	int image;
+	// set if the image is freed before it finishes loading, so the job is thrown away. Guarded by the loader mutex.
+	int cancelled;
+	EZimagefun onLoaded;
+	// decoded pixels, or NULL if decoding failed
+	unsigned char* pixels;
+	int width;
+	int height;
+	// hash and size of the file contents
+	unsigned long long hash;
+	long long fileSize;
+	struct EzImageJob* next;
+};
+
+// Decodes images on worker threads. The GL upload happens on the render thread, since that's where the context is.
+struct EzImageLoader {
+	EzThread workers[EZ_MAX_IMAGE_WORKERS];
+	// number of worker threads running. 0 until the first background load.
+	int workerCount;
+	EzMutex mutex;
+	// signalled when a job is queued, or when the workers should stop
+	EzCond wake;
+	// signalled when a job finishes decoding
+	EzCond decoded;
+	// jobs waiting for a worker, oldest first
+	struct EzImageJob* pending;
+	struct EzImageJob* pendingTail;
+	// jobs a worker is decoding, in no particular order, so they can still be cancelled
+	struct EzImageJob* active;
+	// jobs waiting to be uploaded, oldest first
+	struct EzImageJob* ready;
+	struct EzImageJob* readyTail;
+	// number of jobs queued or being decoded
+	int decoding;
+	int shutdown;
+	// max time per frame spent uploading, in seconds
+	double uploadBudget;
+};
+
+#ifdef EZ_HEADLESS
+// Default number of frames a headless run draws
+#define EZ_DEFAULT_HEADLESS_FRAMES 300
+
+// Offscreen rendering for headless builds: an EGL context with no window, drawing into a framebuffer object
+struct EzHeadless {
+	EGLDisplay display;
+	EGLContext context;
+	unsigned int framebuffer;
+	unsigned int colourBuffer;
+	unsigned int depthBuffer;
+	int shouldClose;
+	// number of frames to draw, and the number drawn so far
+	int frames;
+	int frame;
+	// save every nth frame as an image, or 0 for none
+	int dumpInterval;
+	// time taken by each frame, in seconds
+	double* frameTimes;
+	// totals of the frame stats, for averaging
+	EZframestats totals;
+};
+#endif
+
+// Drawing on the CPU instead of through OpenGL. See ezSetRenderer()
+struct EzSoftwareRenderer {
+	// whether objects are being drawn by the software rasterizer this frame
+	int active;
+	// the renderer to use from the start of the next frame
+	int requested;
+	int initialised;
+	// texture and framebuffer the rasterized frame is copied through to reach the window
+	unsigned int texture;
+	unsigned int framebuffer;
+	int textureWidth;
+	int textureHeight;
+};
+
+// Phase timings of recent frames, see ezGetProfile()
+struct EzProfiler {
+	// time each phase took, in seconds, for the last EZ_PROFILE_FRAMES frames. head is where the next frame goes.
+	double phases[EZ_PROFILE_FRAMES][EZ_PHASE_COUNT];
+	// time each whole frame took
+	double frames[EZ_PROFILE_FRAMES];
+	int head;
+	// phase times of the frame in progress, so the history stays whole until it's done
+	double current[EZ_PHASE_COUNT];
+	// number of frames recorded, up to EZ_PROFILE_FRAMES
+	int count;
+	// time the phase in progress started, and its name, or NULL outside the main loop
+	double mark;
+	const char* phaseName;
+	int overlay;
+	// object used to draw each rectangle of the overlay
+	EZobject* overlayRect;
+};
+
+// Events each thread can hold before they're written out. One slot is always left empty.
+#define EZ_TRACE_RING_EVENTS 8192
+// Most threads that can record events
+#define EZ_TRACE_MAX_THREADS 32
+// Nesting depth to which unmatched ends are caught
+#define EZ_TRACE_MAX_DEPTH 64
+
+// A trace event in Chrome's trace event format: 'B'egin, 'E'nd or 'X' (complete, with a duration)
+struct EzTraceEvent {
+	const char* name;
+	char phase;
+	// microseconds since tracing started
+	double time;
+	double duration;
+};
+
+// Events recorded by one thread, waiting to be written. Only that thread adds events and only the render thread
+// takes them out, so it needs no lock: each side only moves its own end, and only once the events between are ready.
+struct EzTraceRing {
+	struct EzTraceEvent events[EZ_TRACE_RING_EVENTS];
+	// next event to be written by the thread, and next event to be written out
+	EzAtomic head;
+	EzAtomic tail;
+	// events that didn't fit, and how many of those had happened when the current trace started
+	EzAtomic dropped;
+	long droppedBefore;
+	const char* threadName;
+	// whether the thread's name has been written to the current file
+	int named;
+};
+
+// Writes events from every thread to a Chrome trace file. See ezTraceStart()
+struct EzTracer {
+	FILE* file;
+	EzAtomic recording;
+	// whether an event has been written yet, so the next needs a comma before it
+	int written;
+	// ezTime() when tracing started
+	double start;
+	// GPU timestamp (in nanoseconds) matching start, for converting GPU times
+	long long gpuStart;
+	// held while adding a ring or writing events out
+	EzMutex mutex;
+	struct EzTraceRing* rings[EZ_TRACE_MAX_THREADS];
+	int ringCount;
+	// ring for GPU times, which are read back on the render thread but shown on their own row
+	struct EzTraceRing* gpuRing;
+};
+
+// Number of frames of GPU timestamps in flight, so results can be read a couple of frames late without waiting on the GPU
+#define EZ_GPU_TIMER_FRAMES 3
+// Timestamps per frame: the start, clear, submit and present, a begin and end for each scope, and one after each batch
+#define EZ_GPU_MAX_STAMPS (4 + 2 * EZ_GPU_MAX_SCOPES + EZ_GPU_MAX_BATCHES)
+
+// What a GPU timestamp marks the end of
+#define EZ_GPU_STAMP_START 0
+#define EZ_GPU_STAMP_CLEAR 1
+#define EZ_GPU_STAMP_BATCH 2
+#define EZ_GPU_STAMP_SCOPE_BEGIN 3
+#define EZ_GPU_STAMP_SCOPE_END 4
+#define EZ_GPU_STAMP_SUBMIT 5
+#define EZ_GPU_STAMP_PRESENT 6
+
+// GL_TIMESTAMP queries written at points through each frame, see ezGetGpuStats()
+struct EzGpuTimer {
+	// 0 if the driver can't do timer queries
+	int supported;
+	GLuint queries[EZ_GPU_TIMER_FRAMES][EZ_GPU_MAX_STAMPS];
+	// what each query marks, and the name of the scope for scope queries
+	int kinds[EZ_GPU_TIMER_FRAMES][EZ_GPU_MAX_STAMPS];
+	const char* names[EZ_GPU_TIMER_FRAMES][EZ_GPU_MAX_STAMPS];
+	// queries issued in each frame, and whether they're still waiting to be read
+	int counts[EZ_GPU_TIMER_FRAMES];
+	int pending[EZ_GPU_TIMER_FRAMES];
+	// frame being recorded
+	int current;
+	// batch and scope timestamps recorded this frame
+	int batches;
+	int scopes;
+	// scopes open, and how many of those are past the limit and have no timestamps.
+	// Every scope begun after the limit is reached is inside the ones before it, so those are always the innermost.
+	int depth;
+	int untimed;
+	// frames dropped since the last results, and the last results
+	int dropped;
+	EZgpustats last;
+};
+
+// How OpenGL errors reach the program. See ezSetOpenGLErrorFunction()
+struct EzDebugOutput {
+	// whether the driver reports messages through KHR_debug. If not, glGetError is polled once a frame instead.
+	int available;
+	// least severe messages reported, an EZ_GL_SEVERITY_*
+	int minSeverity;
+	// whether messages are reported during the call that caused them
+	int synchronous;
+};
+
+struct EzGlobalContext {
+#ifdef EZ_HEADLESS
+	struct EzHeadless headless;
+#endif
+	GLFWwindow* window;
+	EZkeyfun keyFun;
+	EZmousefun mouseFun;
+	EZclickfun clickFun;
+	EZresizefun resizeFun;
+	EZmemerrfun memErrFun;
+	EZglerrorfun glErrorFun;
+	int winWidth;
+	int winHeight;
+	// shader variants, indexed by their EZ_VARIANT_* flags
+	struct EzProgram programs[EZ_VARIANT_COUNT];
+	struct EzShaderCache shaderCache;
+	struct EzObjectPool objects;
+	struct EzBatch batch;
+	struct EzScene scene;
+	struct EzPicker picker;
+	struct EzCamera camera;
+	struct EzGLState glState;
+	struct EzImageTable images;
+	struct EzImageLoader imageLoader;
+	// scratch space for sorting in ezDrawMany, kept between calls
+	struct EzSortEntry* sortEntries;
+	int sortCapacity;
+	EZframestats stats; // stats of the frame in progress
+	EZframestats lastStats; // stats of the last completed frame
+	// whether objects outside the window are skipped
+	int culling;
+	double frameStart; // time the frame in progress started, from ezTime()
+	float clearColour[3];
+	struct EzSoftwareRenderer software;
+	struct EzProfiler profiler;
+	struct EzGpuTimer gpuTimer;
+	struct EzTracer tracer;
+	struct EzDebugOutput debugOutput;
+} g_ezCtx;
+
+// The calling thread's trace events, or NULL until it records its first
+static EZ_THREAD_LOCAL struct EzTraceRing* t_ezTraceRing;
+// Whether there are no rings left for the calling thread
+static EZ_THREAD_LOCAL int t_ezTraceNoRing;
+// Name shown for the calling thread in traces
+static EZ_THREAD_LOCAL const char* t_ezThreadName;
+// How many traced scopes the calling thread is in, and which of the innermost were recorded
+static EZ_THREAD_LOCAL int t_ezTraceDepth;
+static EZ_THREAD_LOCAL unsigned long long t_ezTraceRecorded;
+// Names of the traced scopes the calling thread is in, recorded or not, so OpenGL errors can say where they happened
+static EZ_THREAD_LOCAL const char* t_ezTraceNames[EZ_TRACE_MAX_DEPTH];
+
+// Looks up the locations of all uniforms used by the library in the given program
+static void ezResolveUniforms(const unsigned int program, struct EzUniforms* uniforms) {
+	uniforms->windowSize = glGetUniformLocation(program, "window_size");
+	uniforms->cameraOffset = glGetUniformLocation(program, "camera_offset");
+	uniforms->cameraTransform = glGetUniformLocation(program, "camera_transform");
+	uniforms->textureSampler = glGetUniformLocation(program, "textureSampler");
+}
+
+#ifdef EZ_CHECK_UNIFORMS
+// Compares the cached uniform table of a program with the locations the driver currently reports.
+// Prints any mismatch to stderr.
+static void ezCheckUniforms(const struct EzProgram* program) {
+	struct EzUniforms live;
+	ezResolveUniforms(program->id, &live);
+
+	if (memcmp(&live, &(program->uniforms), sizeof(struct EzUniforms)) != 0) {
+		fprintf(stderr, "Cached uniform locations of program %u are out of date!\n", program->id);
+	}
+}
+#endif
+
+// ==================
+// API Implementation
+// ===================
+
+// Object Pool
+
+// Grows every field array of the pool to the given capacity and adds the new slots to the free list.
+// Returns 0 if the memory cannot be allocated, in which case the pool is left as it was.
+static int ezGrowPool(const int capacity) {
+	struct EzObjectPool* pool = &(g_ezCtx.objects);
+
+#define EZ_GROW_FIELD(field) \
+	{ \
+		void* grown = realloc(pool->field, sizeof(*(pool->field)) * capacity); \
+		if (grown == NULL) return 0; \
+		pool->field = grown; \
+	}
+
+	EZ_GROW_FIELD(r);
+	EZ_GROW_FIELD(g);
+	EZ_GROW_FIELD(b);
+	EZ_GROW_FIELD(x);
+	EZ_GROW_FIELD(y);
+	EZ_GROW_FIELD(anchorX);
+	EZ_GROW_FIELD(anchorY);
+	EZ_GROW_FIELD(width);
+	EZ_GROW_FIELD(height);
+	EZ_GROW_FIELD(rotation);
+	EZ_GROW_FIELD(scaleX);
+	EZ_GROW_FIELD(scaleY);
+	EZ_GROW_FIELD(radii);
+	EZ_GROW_FIELD(borderWidth);
+	EZ_GROW_FIELD(borderColour);
+	EZ_GROW_FIELD(texture);
+	EZ_GROW_FIELD(sceneIndex);
+	EZ_GROW_FIELD(generation);
+	EZ_GROW_FIELD(nextFree);
+#undef EZ_GROW_FIELD
+
+	// chain the new slots onto the end of the free list, lowest first
+	for (int slot = pool->capacity; slot < capacity; slot++) {
+		pool->generation[slot] = 0;
+		pool->nextFree[slot] = slot + 1 < capacity ? slot + 1 : -1;
+	}
+
+	if (pool->freeTail >= 0) {
+		pool->nextFree[pool->freeTail] = pool->capacity;
+	} else {
+		pool->freeHead = pool->capacity;
+	}
+
+	pool->freeTail = capacity - 1;
+	pool->capacity = capacity;
+	return 1;
+}
+
+static void ezFreePool(void) {
+	struct EzObjectPool* pool = &(g_ezCtx.objects);
+
+	free(pool->r);
+	free(pool->g);
+	free(pool->b);
+	free(pool->x);
+	free(pool->y);
+	free(pool->anchorX);
+	free(pool->anchorY);
+	free(pool->width);
+	free(pool->height);
+	free(pool->rotation);
+	free(pool->scaleX);
+	free(pool->scaleY);
+	free(pool->radii);
+	free(pool->borderWidth);
+	free(pool->borderColour);
+	free(pool->texture);
+	free(pool->sceneIndex);
+	free(pool->generation);
+	free(pool->nextFree);
+	memset(pool, 0, sizeof(struct EzObjectPool));
+	pool->freeHead = -1;
+	pool->freeTail = -1;
+}
+
+static EZobject* ezMakeHandle(const int slot) {
+	const uintptr_t generation = g_ezCtx.objects.generation[slot] & EZ_HANDLE_GENERATION_MASK;
+	return (EZobject*)((generation << EZ_HANDLE_INDEX_BITS) | (uintptr_t)(slot + 1));
+}
+
+// Gets the pool slot of an object handle, or -1 if the handle is NULL or the object has been deleted
+static int ezHandleSlot(const EZobject* object) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+	const uintptr_t handle = (uintptr_t)object;
+	const int slot = (int)(handle & EZ_HANDLE_INDEX_MASK) - 1;
+
+	if (slot < 0 || slot >= pool->capacity || pool->nextFree[slot] != EZ_SLOT_IN_USE
+			|| (pool->generation[slot] & EZ_HANDLE_GENERATION_MASK) != handle >> EZ_HANDLE_INDEX_BITS) {
+		return -1;
+	}
+
+	return slot;
+}
+
+// Gets the pool slot of an object handle.
+// Returns -1 and prints an error if the handle is NULL or the object has been deleted.
+static int ezObjectSlot(const EZobject* object) {
+	const int slot = ezHandleSlot(object);
+
+	if (slot < 0) {
+		fprintf(stderr, "Invalid object! It may have already been deleted.\n");
+	}
+
+	return slot;
+}
+
+// GL State
+
+// Counts a state change as issued or elided in the frame stats, returning whether it should be issued
+static int ezStateChanged(const int changed) {
+	if (changed) {
+		g_ezCtx.stats.stateCalls++;
+	} else {
+		g_ezCtx.stats.elidedStateCalls++;
+	}
+
+	return changed;
+}
+
+static void ezStateUseProgram(const unsigned int program) {
+	if (ezStateChanged(g_ezCtx.glState.program != program)) {
+		glUseProgram(program);
+		g_ezCtx.glState.program = program;
+	}
+}
+
+static void ezStateBindVertexArray(const unsigned int vao) {
+	if (ezStateChanged(g_ezCtx.glState.vertexArray != vao)) {
+		glBindVertexArray(vao);
+		g_ezCtx.glState.vertexArray = vao;
+	}
+}
+
+static void ezStateBindArrayBuffer(const unsigned int buffer) {
+	if (ezStateChanged(g_ezCtx.glState.arrayBuffer != buffer)) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		g_ezCtx.glState.arrayBuffer = buffer;
+	}
+}
+
+// Binds a 2D texture to the given texture unit, switching the active unit only if needed
+static void ezStateBindTexture(const int unit, const unsigned int texture) {
+	struct EzGLState* state = &(g_ezCtx.glState);
+
+	if (!ezStateChanged(state->textures[unit] != texture)) {
+		return;
+	}
+
+	if (ezStateChanged(state->activeTexture != unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		state->activeTexture = unit;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	state->textures[unit] = texture;
+}
+
+static void ezStateBlend(const int enabled) {
+	if (ezStateChanged(g_ezCtx.glState.blend != enabled)) {
+		if (enabled) {
+			glEnable(GL_BLEND);
+		} else {
+			glDisable(GL_BLEND);
+		}
+
+		g_ezCtx.glState.blend = enabled;
+	}
+}
+
+// Forgets a buffer or texture that is being deleted. OpenGL unbinds deleted objects itself.
+static void ezStateForgetBuffer(const unsigned int buffer) {
+	if (g_ezCtx.glState.arrayBuffer == buffer) {
+		g_ezCtx.glState.arrayBuffer = 0;
+	}
+}
+
+static void ezStateForgetTexture(const unsigned int texture) {
+	for (int unit = 0; unit < EZ_TEXTURE_UNITS; unit++) {
+		if (g_ezCtx.glState.textures[unit] == texture) {
+			g_ezCtx.glState.textures[unit] = 0;
+		}
+	}
+}
+
+// Uniform setters for the current program. Each skips the upload if the cached value is the same.
+
+static void ezStateUniform2f(const int location, float cache[2], const float x, const float y) {
+	if (ezStateChanged(cache[0] != x || cache[1] != y)) {
+		glUniform2f(location, x, y);
+		cache[0] = x;
+		cache[1] = y;
+	}
+}
+
+// Sets a mat2 uniform, given in column major order
+static void ezStateUniformMatrix2f(const int location, float cache[4], const float matrix[4]) {
+	if (ezStateChanged(memcmp(cache, matrix, sizeof(float) * 4) != 0)) {
+		glUniformMatrix2fv(location, 1, GL_FALSE, matrix);
+		memcpy(cache, matrix, sizeof(float) * 4);
+	}
+}
+
+static void ezStateUniform1i(const int location, int* cache, const int value) {
+	if (ezStateChanged(*cache != value)) {
+		glUniform1i(location, value);
+		*cache = value;
+	}
+}
+
+// Shaders
+// The fragment shader is compiled in several variants, each with only the features its batch needs.
+// Variants are built the first time a batch needs them, apart from the one that can draw anything.
+
+// Taken from another project of mine
+// Checks the given shader for errors.
+// If errors are found, the error log is displayed, the window is destroyed, GLFW is shut down, and the program terminates with status -1.
+static void ezCheckShaderErrors(const int shader, const char* shaderType);
+
+// The shared source of every variant. Compiled after the #version line and the variant's #defines.
+static const char* g_ezVertexShaderSource =
+	// a corner of the unit quad
+	"layout(location = 0) in vec2 vertexPosition;\n"
+	// per object data
+	"layout(location = 1) in vec2 position;\n"
+	"layout(location = 2) in vec2 dimensions;\n"
+	"layout(location = 3) in vec2 anchor;\n"
+	"layout(location = 4) in vec3 colour;\n"
+	"layout(location = 5) in vec4 radii;\n" // bottom left, bottom right, top right, top left
+	"layout(location = 6) in float textured;\n"
+	"layout(location = 7) in float depth;\n"
+	"layout(location = 8) in vec4 uvRect;\n"
+	"layout(location = 9) in float borderWidth;\n"
+	"layout(location = 10) in vec3 borderColour;\n"
+	"layout(location = 11) in float rotation;\n"
+	"layout(location = 12) in vec2 scale;\n"
+
+	"out vec2 posPass;\n"
+	"out vec2 uvPass;\n"
+	"flat out vec3 colourPass;\n"
+	"flat out vec2 dimensionsPass;\n"
+	"flat out vec4 radiiPass;\n"
+	"flat out float texturedPass;\n"
+	"flat out vec4 uvRectPass;\n"
+	"flat out float borderWidthPass;\n"
+	"flat out vec3 borderColourPass;\n"
+
+	"uniform vec2 window_size;\n"
+	// the camera's position, relative to the point the instance positions are relative to
+	"uniform vec2 camera_offset;\n"
+	// the camera's zoom and rotation
+	"uniform mat2 camera_transform;\n"
+
+	"void main() {\n"
+	// position relative to the shape, before it's turned and stretched. Will be interpolated for each pixel when passed to the fragment shader,
+	// which works out the distance to the edge in these units, so rounded corners stay round however the shape is turned.
+	"  posPass = vertexPosition * dimensions;\n"
+	"  vec2 corner = vertexPosition;\n"
+	"#ifdef EZ_FILLETED\n"
+	// soft edges blend over the pixels the edge runs through, including those whose centres are just outside the shape,
+	// so the quad is grown by a pixel on every side to cover them
+	"  if (max(max(radii.x, radii.y), max(radii.z, radii.w)) > 0.0 || borderWidth > 0.0) {\n"
+	"    vec2 pixel = 1.0 / max(abs(scale) * length(camera_transform[0]), vec2(0.0001));\n"
+	"    posPass = vertexPosition * (dimensions + 2.0 * pixel) - pixel;\n"
+	"    corner = posPass / max(dimensions, vec2(0.0001));\n"
+	"  }\n"
+	"#endif\n"
+	"  uvPass = mix(uvRect.xy, uvRect.zw, corner);\n" // the image's area of the texture, which is all of it unless it's in an atlas
+	"  colourPass = colour;\n"
+	"  dimensionsPass = dimensions;\n"
+	"  radiiPass = radii;\n"
+	"  texturedPass = textured;\n"
+	"  uvRectPass = uvRect;\n"
+	"  borderWidthPass = borderWidth;\n"
+	"  borderColourPass = borderColour;\n"
+	// turned and stretched about the anchor point
+	"  float sine = sin(rotation);\n"
+	"  float cosine = cos(rotation);\n"
+	"  vec2 world = position + mat2(cosine, sine, -sine, cosine) * ((posPass - anchor * dimensions) * scale);\n"
+	// through the camera, which zooms and rotates about the centre of the window
+	"  vec2 half_size = window_size * 0.5;\n"
+	"  vec2 pixel = half_size + camera_transform * (world - camera_offset - half_size);\n"
+	// map from 0,0,WIDTH,HEIGHT to -1,1,-1,1.
+	"  gl_Position = vec4((pixel / half_size) - 1, depth, 1.0);\n"
+	"}";
+
+static const char* g_ezFragmentShaderSource =
+	"in vec2 posPass;\n"
+	"in vec2 uvPass;\n"
+	"flat in vec3 colourPass;\n"
+	"flat in vec2 dimensionsPass;\n"
+	"flat in vec4 radiiPass;\n"
+	"flat in float texturedPass;\n"
+	"flat in vec4 uvRectPass;\n"
+	"flat in float borderWidthPass;\n"
+	"flat in vec3 borderColourPass;\n"
+
+	"uniform sampler2D textureSampler;\n"
+
+	"#ifdef EZ_FILLETED\n"
+	// Signed distance from the edge of a box with rounded corners, centred on the origin. Negative inside.
+	// Each quadrant uses its own corner's radius, limited to half the shorter side so corners never overlap.
+	"float roundedBox(vec2 p, vec2 halfSize, vec4 radii) {\n"
+	"  vec2 side = p.x < 0.0 ? radii.xw : radii.yz;\n"
+	"  float radius = min(p.y < 0.0 ? side.x : side.y, min(halfSize.x, halfSize.y));\n"
+	"  vec2 q = abs(p) - halfSize + radius;\n"
+	"  return min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - radius;\n"
+	"}\n"
+
+	// How much of a pixel is inside an edge, given the distance to it and how much that distance changes per pixel
+	"float coverage(float distance, float pixel) {\n"
+	"  return clamp(0.5 - distance / pixel, 0.0, 1.0);\n"
+	"}\n"
+	"#endif\n"
+
+	"void main() {\n"
+	"  vec4 colour = vec4(colourPass, 1.0);\n"
+	"#ifdef EZ_FILLETED\n"
+	// the derivatives have to be taken outside of any branch
+	"  vec2 halfSize = dimensionsPass * 0.5;\n"
+	"  float distance = roundedBox(posPass - halfSize, halfSize, radiiPass);\n"
+	"  float pixel = max(fwidth(distance), 0.0001);\n"
+	"  vec2 uvDx = dFdx(uvPass);\n"
+	"  vec2 uvDy = dFdy(uvPass);\n"
+	// straight edged objects with no border stay sharp, the same as in the other variants
+	"  bool soft = max(max(radiiPass.x, radiiPass.y), max(radiiPass.z, radiiPass.w)) > 0.0 || borderWidthPass > 0.0;\n"
+	"  float alpha = soft ? coverage(distance, pixel) : 1.0;\n"
+	"  float inner = soft ? coverage(distance + borderWidthPass, pixel) : 1.0;\n" // 0 on the border, 1 inside it
+	"  if (alpha <= 0.0) discard;\n"
+	"#endif\n"
+
+	// If Texture, use that. Untextured objects can share a textured batch, so it still has to check.
+	"#ifdef EZ_TEXTURED\n"
+	"  if (texturedPass != 0.0) {\n"
+	"#ifdef EZ_FILLETED\n"
+	// the quad of a soft edged object reaches past its image, which may have neighbours in an atlas.
+	// The mipmap level still comes from the unclamped coordinates, so it's the same as for a sharp object.
+	"    vec2 uv = clamp(uvPass, min(uvRectPass.xy, uvRectPass.zw), max(uvRectPass.xy, uvRectPass.zw));\n"
+	"    colour = textureGrad(textureSampler, uv, uvDx, uvDy) * colour;\n"
+	// see-through parts of the image still get the border drawn over them
+	"    if (colour.a <= 0.0) {\n"
+	"      if (inner >= 1.0) discard;\n"
+	"      alpha *= 1.0 - inner;\n"
+	"      inner = 0.0;\n"
+	"    }\n"
+	"#else\n"
+	"    colour = texture(textureSampler, uvPass) * colour;\n"
+	"    if (colour.a <= 0.0) discard;\n"
+	"#endif\n"
+	"  }\n"
+	"#endif\n"
+
+	"#ifdef EZ_FILLETED\n"
+	"  gl_FragColor = vec4(mix(borderColourPass, colour.rgb, inner), alpha);\n"
+	"#else\n"
+	"  gl_FragColor = colour;\n"
+	"#endif\n"
+	"}";
+
+// Compiles one stage of a variant
+static unsigned int ezCompileVariantShader(const int variant, const GLenum type, const char* source) {
+	const char* sources[4] = {
+		"#version 330 core\n",
+		(variant & EZ_VARIANT_TEXTURED) ? "#define EZ_TEXTURED\n" : "",
+		(variant & EZ_VARIANT_FILLETED) ? "#define EZ_FILLETED\n" : "",
+		source
+	};
+
+	unsigned int shader = glCreateShader(type);
+	glShaderSource(shader, 4, sources, NULL);
+	glCompileShader(shader);
+	ezCheckShaderErrors(shader, type == GL_VERTEX_SHADER ? "vertex" : "fragment");
+	return shader;
+}
+
+// Sets up a freshly linked or loaded variant for use
+static void ezSetUpProgram(const int variant, const unsigned int id) {
+	struct EzProgram* program = &(g_ezCtx.programs[variant]);
+
+	// Use the Shader
+	ezStateUseProgram(id);
+	program->id = id;
+	ezResolveUniforms(id, &(program->uniforms));
+	// gotta set the sampler to use active texture 0. This is stored in the program, so it only needs setting once.
+	// (the caches start out impossible so the first uploads aren't skipped)
+	program->values.textureSampler = -1;
+	program->values.windowSize[0] = -1.0f;
+	program->values.windowSize[1] = -1.0f;
+	program->values.cameraOffset[0] = NAN;
+	program->values.cameraTransform[0] = NAN;
+
+	ezStateUniform1i(program->uniforms.textureSampler, &(program->values.textureSampler), 0);
+}
+
+// Defined with the rest of the platform and image code
+static double ezTime(void);
+static unsigned char* ezReadFile(const char* fileName, long long* size);
+static unsigned long long ezHash(const unsigned char* data, const long long size);
+
+// Start of a cached program binary file
+struct EzProgramCacheHeader {
+	char magic[4];
+	// the key the file was saved under, in case of a clash in the file name
+	unsigned long long key;
+	unsigned int format;
+	int length;
+	// seconds it took to compile and link the program from source
+	double compileTime;
+};
+
+// Whether programs can be cached: turned on, and the driver can hand back linked programs
+static int ezShaderCacheUsable(void) {
+	struct EzShaderCache* cache = &(g_ezCtx.shaderCache);
+
+	if (!cache->checked) {
+		GLint formats = 0;
+
+		if (GLEW_ARB_get_program_binary) {
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		}
+
+		cache->supported = formats > 0;
+		cache->checked = 1;
+	}
+
+	return cache->directory && cache->supported;
+}
+
+// Identifies a variant as built by this driver. A new driver or a change to the shaders gives a new key,
+// and so a new file, rather than a program the driver would reject.
+static unsigned long long ezProgramCacheKey(const int variant) {
+	const char* parts[6] = {
+		(const char*)glGetString(GL_VENDOR),
+		(const char*)glGetString(GL_RENDERER),
+		(const char*)glGetString(GL_VERSION),
+		(variant & EZ_VARIANT_TEXTURED) ? "textured" : "untextured",
+		(variant & EZ_VARIANT_FILLETED) ? "filleted" : "sharp",
+		NULL
+	};
+
+	unsigned long long key = ezHash((const unsigned char*)g_ezVertexShaderSource, strlen(g_ezVertexShaderSource));
+	key ^= ezHash((const unsigned char*)g_ezFragmentShaderSource, strlen(g_ezFragmentShaderSource)) * 31;
+
+	for (int i = 0; parts[i]; i++) {
+		key = key * 31 + ezHash((const unsigned char*)parts[i], strlen(parts[i]));
+	}
+
+	return key;
+}
+
+static void ezProgramCachePath(char* path, const size_t size, const unsigned long long key) {
+	snprintf(path, size, "%s/program_%016llx.bin", g_ezCtx.shaderCache.directory, key);
+}
+
+// Loads a variant from the cache. Returns 0 if it isn't there, or the driver won't take it.
+static int ezLoadCachedProgram(const int variant, const unsigned long long key, const double start) {
+	struct EzShaderCache* cache = &(g_ezCtx.shaderCache);
+	char path[1024];
+	long long size = 0;
+
+	ezProgramCachePath(path, sizeof(path), key);
+	unsigned char* file = ezReadFile(path, &size);
+
+	if (file == NULL) {
+		return 0;
+	}
+
+	struct EzProgramCacheHeader header;
+	int loaded = 0;
+
+	if (size >= (long long)sizeof(header)) {
+		memcpy(&header, file, sizeof(header));
+	}
+
+	if (size >= (long long)sizeof(header) && memcmp(header.magic, "EZPB", 4) == 0 && header.key == key
+			&& header.length == size - (long long)sizeof(header)) {
+		unsigned int id = glCreateProgram();
+		glProgramBinary(id, header.format, file + sizeof(header), header.length);
+
+		GLint success = 0;
+		glGetProgramiv(id, GL_LINK_STATUS, &success);
+
+		if (success) {
+			ezSetUpProgram(variant, id);
+			const double loadTime = ezTime() - start;
+			cache->stats.hits++;
+			cache->stats.loadTime += loadTime * 1000.0;
+
+			if (header.compileTime > loadTime) {
+				cache->stats.savedTime += (header.compileTime - loadTime) * 1000.0;
+			}
+
+			loaded = 1;
+		} else {
+			glDeleteProgram(id);
+		}
+	}
+
+	// anything wrong with the file is fixed by compiling and saving over it
+	free(file);
+	return loaded;
+}
+
+// Saves a variant's program to the cache, creating the directory if needed
+static void ezSaveCachedProgram(const unsigned int id, const unsigned long long key, const double compileTime) {
+	GLint length = 0;
+	glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0) {
+		return;
+	}
+
+	struct EzProgramCacheHeader header;
+	unsigned char* binary = malloc(length);
+
+	if (binary == NULL) {
+		return;
+	}
+
+	GLenum format;
+	glGetProgramBinary(id, length, NULL, &format, binary);
+
+	memcpy(header.magic, "EZPB", 4);
+	header.key = key;
+	header.format = format;
+	header.length = length;
+	header.compileTime = compileTime;
+
+	// fails harmlessly if it already exists
+#ifdef _WIN32
+	_mkdir(g_ezCtx.shaderCache.directory);
+#else
+	mkdir(g_ezCtx.shaderCache.directory, 0777);
+#endif
+
+	char path[1024];
+	ezProgramCachePath(path, sizeof(path), key);
+	FILE* file = fopen(path, "wb");
+
+	if (file) {
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(binary, 1, length, file);
+		fclose(file);
+	}
+
+	free(binary);
+}
+
+// Compiles and links a variant, or loads it from the cache. Returns 0 if it fails to link.
+static int ezBuildProgram(const int variant) {
+	struct EzShaderCache* cache = &(g_ezCtx.shaderCache);
+	const double start = ezTime();
+	const int cached = ezShaderCacheUsable();
+	const unsigned long long key = cached ? ezProgramCacheKey(variant) : 0;
+
+	ezTraceBegin("compile shader");
+
+	if (cached && ezLoadCachedProgram(variant, key, start)) {
+		ezTraceEnd();
+		return 1;
+	}
+
+	unsigned int vertexShader = ezCompileVariantShader(variant, GL_VERTEX_SHADER, g_ezVertexShaderSource);
+	unsigned int fragmentShader = ezCompileVariantShader(variant, GL_FRAGMENT_SHADER, g_ezFragmentShaderSource);
+
+	unsigned int shaderProgram = glCreateProgram();
+	glAttachShader(shaderProgram, vertexShader);
+	glAttachShader(shaderProgram, fragmentShader);
+
+	if (cached) {
+		glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	glLinkProgram(shaderProgram);
+
+	// clean up memory. They're only really deleted once the program is.
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	int success;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+
+	if (!success) {
+		printf("Shader Link Error");
+		char infoLog[512];
+		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+		printf(": %s\n", infoLog);
+		glDeleteProgram(shaderProgram);
+		ezTraceEnd();
+		return 0;
+	}
+
+	ezSetUpProgram(variant, shaderProgram);
+
+	const double compileTime = ezTime() - start;
+	cache->stats.misses++;
+	cache->stats.compileTime += compileTime * 1000.0;
+
+	if (cached) {
+		ezSaveCachedProgram(shaderProgram, key, compileTime);
+	}
+
+	ezTraceEnd();
+	return 1;
+}
+
+void ezSetShaderCacheDirectory(const char* directory) {
+	struct EzShaderCache* cache = &(g_ezCtx.shaderCache);
+
+	free(cache->directory);
+	cache->directory = NULL;
+
+	if (directory) {
+		cache->directory = malloc(strlen(directory) + 1);
+
+		if (cache->directory) {
+			strcpy(cache->directory, directory);
+		}
+	}
+}
+
+void ezGetShaderCacheStats(EZshadercachestats* stats) {
+	*stats = g_ezCtx.shaderCache.stats;
+}
+
+// Makes the given variant the current program, building it if it hasn't been yet
+static void ezUseProgram(int variant, const double origin[2]) {
+	struct EzProgram* program = &(g_ezCtx.programs[variant]);
+
+	// should never fail once the general variant has built, but if it does that variant can stand in
+	if (program->id == 0 && !ezBuildProgram(variant)) {
+		variant = EZ_VARIANT_ALL;
+		program = &(g_ezCtx.programs[variant]);
+	}
+
+	ezStateUseProgram(program->id);
+	ezStateUniform2f(program->uniforms.windowSize, program->values.windowSize, (float)g_ezCtx.winWidth, (float)g_ezCtx.winHeight);
+
+	// the camera's position is sent relative to the instances' origin, which keeps it small near the camera
+	const struct EzCamera* camera = &(g_ezCtx.camera);
+	const float sine = (float)camera->sine * camera->zoom;
+	const float cosine = (float)camera->cosine * camera->zoom;
+	const float transform[4] = { cosine, sine, -sine, cosine };
+	ezStateUniform2f(program->uniforms.cameraOffset, program->values.cameraOffset, (float)(camera->x - origin[0]), (float)(camera->y - origin[1]));
+	ezStateUniformMatrix2f(program->uniforms.cameraTransform, program->values.cameraTransform, transform);
+}
+
+static void ezFreePrograms(void) {
+	ezStateUseProgram(0);
+
+	for (int variant = 0; variant < EZ_VARIANT_COUNT; variant++) {
+		if (g_ezCtx.programs[variant].id) {
+			glDeleteProgram(g_ezCtx.programs[variant].id);
+			g_ezCtx.programs[variant].id = 0;
+		}
+	}
+
+	ezSetShaderCacheDirectory(NULL);
+}
+
+// Batching
+
+// Points the instance attributes at the instance data starting the given number of bytes into the ring.
+// The instance buffer must be bound, along with the vertex array.
+static void ezPointInstanceAttributes(const long long offset) {
+	const int stride = sizeof(float) * EZ_INSTANCE_SIZE;
+
+	// (location = 1) in vec2 position
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 0));
+	// (location = 2) in vec2 dimensions
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 2));
+	// (location = 3) in vec2 anchor
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 4));
+	// (location = 4) in vec3 colour
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 6));
+	// (location = 5) in vec4 radii
+	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 16));
+	// (location = 6) in float textured
+	glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 10));
+	// (location = 7) in float depth
+	glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 11));
+	// (location = 8) in vec4 uvRect
+	glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 12));
+	// (location = 9) in float borderWidth
+	glVertexAttribPointer(9, 1, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 9));
+	// (location = 10) in vec3 borderColour
+	glVertexAttribPointer(10, 3, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 20));
+	// (location = 11) in float rotation
+	glVertexAttribPointer(11, 1, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 23));
+	// (location = 12) in vec2 scale
+	glVertexAttribPointer(12, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(offset + sizeof(float) * 24));
+}
+
+// Points the bound vertex array's instance attributes at the given offset, unless they already are.
+// Each attribute takes a call of its own, so each is counted as a state change.
+static void ezStatePointInstances(long long* pointed, const long long offset) {
+	if (ezStateChanged(*pointed != offset)) {
+		ezPointInstanceAttributes(offset);
+		g_ezCtx.stats.stateCalls += EZ_INSTANCE_ATTRIBUTES - 1;
+		*pointed = offset;
+	}
+}
+
+// Records the vertex layout in the bound vertex array: the unit quad, and the instance attributes
+// reading from the start of the given buffer. Draws pick out their instances with a base instance.
+static void ezAttachVertexLayout(const unsigned int instanceBuffer) {
+	const struct EzBatch* batch = &(g_ezCtx.batch);
+
+	// Attach the unit quad
+	// (location = 0) in vec2 vertexPosition
+	ezStateBindArrayBuffer(batch->vbo);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void*)0);
+	glEnableVertexAttribArray(0);
+	// the element buffer binding is part of the vertex array, so it stays attached
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->ibo);
+
+	// Attach the instance data. These advance once per object rather than once per vertex.
+	ezStateBindArrayBuffer(instanceBuffer);
+	ezPointInstanceAttributes(0);
+
+	for (int location = 1; location <= EZ_INSTANCE_ATTRIBUTES; location++) {
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+}
+
+// Creates the buffers used for batching. Returns 0 if the staging memory cannot be allocated.
+static int ezInitBatch(void) {
+	struct EzBatch* batch = &(g_ezCtx.batch);
+
+	batch->staging = malloc(EZ_BATCH_BYTES);
+
+	if (batch->staging == NULL) {
+		return 0;
+	}
+
+	batch->instances = NULL;
+	batch->count = 0;
+	batch->texture = 0;
+	batch->variant = 0;
+	batch->depth = 0.0f;
+	batch->depthLevels = 0;
+	batch->offset = 0;
+	batch->pointedOffset = 0;
+	batch->chunk = 0;
+	memset(batch->fences, 0, sizeof(batch->fences));
+
+	glGenVertexArrays(1, &(batch->vao));
+	glGenBuffers(1, &(batch->vbo));
+	glGenBuffers(1, &(batch->ibo));
+	glGenBuffers(1, &(batch->instanceVbo));
+
+	// everything from here until the vertex array is unbound is recorded in it
+	ezStateBindVertexArray(batch->vao);
+
+	// Vertex Coords, which double as the UV Coords
+	const float vertices[8] = {
+		0, 1,
+		0, 0,
+		1, 0,
+		1, 1
+	};
+
+	ezStateBindArrayBuffer(batch->vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	const unsigned int indices[6] = {
+		0, 2, 1, /* clockwise |\ */
+		0, 3, 2 /* clockwise \| */
+	};
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	// The instance ring. Where the driver allows it, the ring is mapped once and stays mapped, so instances are
+	// written straight to memory the GPU reads from. Coherent mapping means nothing needs flushing either.
+	ezStateBindArrayBuffer(batch->instanceVbo);
+	const long long ringBytes = (long long)EZ_STREAM_CHUNK_BYTES * EZ_STREAM_CHUNKS;
+	batch->persistent = NULL;
+
+	if (GLEW_ARB_buffer_storage) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, ringBytes, NULL, flags);
+		// if this fails, the storage still allows mapping a batch at a time like below
+		batch->persistent = glMapBufferRange(GL_ARRAY_BUFFER, 0, ringBytes, flags);
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, ringBytes, NULL, GL_STREAM_DRAW);
+	}
+
+	ezAttachVertexLayout(batch->instanceVbo);
+	ezStateBindVertexArray(0);
+	return 1;
+}
+
+static void ezFreeBatch(void) {
+	struct EzBatch* batch = &(g_ezCtx.batch);
+
+	ezStateBindVertexArray(0);
+	glDeleteVertexArrays(1, &(batch->vao));
+	ezStateForgetBuffer(batch->vbo);
+	ezStateForgetBuffer(batch->instanceVbo);
+
+	for (int chunk = 0; chunk < EZ_STREAM_CHUNKS; chunk++) {
+		if (batch->fences[chunk]) {
+			glDeleteSync(batch->fences[chunk]);
+			batch->fences[chunk] = 0;
+		}
+	}
+
+	// deleting the instance buffer unmaps it too
+	glDeleteBuffers(1, &(batch->vbo));
+	glDeleteBuffers(1, &(batch->ibo));
+	glDeleteBuffers(1, &(batch->instanceVbo));
+	free(batch->staging);
+	batch->staging = NULL;
+	batch->instances = NULL;
+	batch->persistent = NULL;
+
+	free(g_ezCtx.sortEntries);
+	g_ezCtx.sortEntries = NULL;
+	g_ezCtx.sortCapacity = 0;
+}
+
+// Writes the instance data of the object in the given pool slot to the batch, flushing first if the texture changes or the batch is full
+static void ezBatchObject(const int slot);
+
+// Regenerates the mipmaps of atlas pages that have had images added
+static void ezUpdateAtlasMipmaps(void);
+
+// Records when the GPU gets to this point in the frame, if there's room. kind is an EZ_GPU_STAMP_*.
+static void ezGpuStamp(const int kind, const char* name);
+
+// Waits for the GPU to finish reading a chunk of the instance ring
+static void ezWaitForChunk(const int chunk) {
+	struct EzBatch* batch = &(g_ezCtx.batch);
+
+	if (batch->fences[chunk] == 0) {
+		return;
+	}
+
+	ezTraceBegin("wait for instance ring");
+
+	// only happens when the GPU is a whole ring behind, so the wait is worth it rather than a rare stall
+	GLenum result;
+
+	do {
+		result = glClientWaitSync(batch->fences[chunk], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+	} while (result == GL_TIMEOUT_EXPIRED);
+
+	glDeleteSync(batch->fences[chunk]);
+	batch->fences[chunk] = 0;
+	ezTraceEnd();
+}
+
+// Finds room in the instance ring for a full batch, and points the batch's instances at it
+static void ezReserveInstances(void) {
+	struct EzBatch* batch = &(g_ezCtx.batch);
+
+	// batches never straddle chunks. Move on to the next, fencing this one after the draws already issued from it.
+	if (batch->offset + (long long)EZ_BATCH_BYTES > (batch->chunk + 1) * (long long)EZ_STREAM_CHUNK_BYTES) {
+		batch->fences[batch->chunk] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		batch->chunk = (batch->chunk + 1) % EZ_STREAM_CHUNKS;
+		ezWaitForChunk(batch->chunk);
+		batch->offset = batch->chunk * (long long)EZ_STREAM_CHUNK_BYTES;
+	}
+
+	if (batch->persistent) {
+		batch->instances = (float*)(batch->persistent + batch->offset);
+		return;
+	}
+
+	// nothing the GPU is still reading is in the range, so no need for the driver to synchronise
+	ezStateBindArrayBuffer(batch->instanceVbo);
+	batch->instances = glMapBufferRange(GL_ARRAY_BUFFER, batch->offset, EZ_BATCH_BYTES,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+
+	if (batch->instances == NULL) {
+		batch->instances = batch->staging;
+	}
+}
+
+// Draws instances of the unit quad in a single draw call, starting from the given instance of the bound vertex array.
+// Its instance attributes read from the given buffer, and point where the given offset says.
+// The origin is the point in the world their positions are relative to.
+static void ezDrawInstances(const int variant, const unsigned int texture, const unsigned int buffer, long long* pointedOffset,
+		const int first, const int count, const double origin[2]) {
+	ezUseProgram(variant, origin);
+	// soft edges are blended over what's already drawn. Nothing else is see-through.
+	ezStateBlend(variant & EZ_VARIANT_FILLETED);
+
+	// Texture. Untextured draws don't sample, so whatever is bound can stay bound.
+	if (texture) {
+		ezUpdateAtlasMipmaps();
+		ezStateBindTexture(0, texture);
+	}
+
+	// the vertex layout stays as it is, and the draw says which instance to start from.
+	// Without a base instance, the attributes have to be pointed at the first instance instead.
+	if (GLEW_ARB_base_instance) {
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, count, (GLuint)first);
+	} else {
+		ezStateBindArrayBuffer(buffer);
+		ezStatePointInstances(pointedOffset, (long long)sizeof(float) * EZ_INSTANCE_SIZE * first);
+		glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, count);
+	}
+
+	ezGpuStamp(EZ_GPU_STAMP_BATCH, NULL);
+
+	g_ezCtx.stats.batches++;
+	g_ezCtx.stats.drawCalls++;
+}
+
+// Sends all objects in the batch to OpenGL in a single draw call
+static void ezFlushBatch(void) {
+	struct EzBatch* batch = &(g_ezCtx.batch);
+
+	if (batch->count == 0) {
+		return;
+	}
+
+	ezTraceBegin("flush batch");
+	ezStateBindVertexArray(batch->vao);
+
+	// the instances are already in the ring, unless it's mapped a batch at a time
+	ezTraceBegin("upload instances");
+	ezStateBindArrayBuffer(batch->instanceVbo);
+	const long long bytes = (long long)sizeof(float) * EZ_INSTANCE_SIZE * batch->count;
+
+	if (batch->instances == batch->staging) {
+		glBufferSubData(GL_ARRAY_BUFFER, batch->offset, bytes, batch->staging);
+	} else if (batch->persistent == NULL) {
+		glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, bytes);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	ezTraceEnd();
+
+	// the ring holds whole instances, so every batch starts on one
+	const int first = (int)(batch->offset / ((long long)sizeof(float) * EZ_INSTANCE_SIZE));
+	ezDrawInstances(batch->variant, batch->texture, batch->instanceVbo, &(batch->pointedOffset), first, batch->count, batch->origin);
+
+	batch->offset += bytes;
+	batch->instances = NULL;
+	batch->count = 0;
+	batch->texture = 0;
+	batch->variant = 0;
+	ezTraceEnd();
+}
+
+#ifndef EZ_HEADLESS
+// Copies the software renderer's frame to the window
+static void ezShowSoftwareFrame(void);
+#endif
+
+// Defined with the rest of the picking code
+static void ezPickEndFrame(void);
+
+// Ends the frame's batching: submits whatever is left and publishes the frame stats
+static void ezEndFrame(void) {
+	if (g_ezCtx.software.active) {
+		ezSoftwareFlush();
+	} else {
+		ezFlushBatch();
+	}
+
+	g_ezCtx.lastStats = g_ezCtx.stats;
+	memset(&(g_ezCtx.stats), 0, sizeof(EZframestats));
+	ezPickEndFrame();
+}
+
+// Orders times (doubles) from shortest to longest
+static int ezCompareTimes(const void* a, const void* b) {
+	const double first = *(const double*)a;
+	const double second = *(const double*)b;
+	return (first > second) - (first < second);
+}
+
+// Platform
+// Normal builds draw to a GLFW window. Headless builds (EZ_HEADLESS) draw offscreen for a set number of frames instead.
+
+#ifdef EZ_HEADLESS
+
+// Seconds since some fixed point in the past
+static double ezTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// Reads the headless options from the command line:
+// --frames=N to draw N frames, --dump=N to save every Nth frame as a PPM image in the working directory.
+static void ezReadHeadlessOptions(const int argc, char** argv) {
+	struct EzHeadless* headless = &(g_ezCtx.headless);
+	headless->frames = EZ_DEFAULT_HEADLESS_FRAMES;
+
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--frames=", 9) == 0) {
+			headless->frames = atoi(argv[i] + 9);
+		} else if (strncmp(argv[i], "--dump=", 7) == 0) {
+			headless->dumpInterval = atoi(argv[i] + 7);
+		} else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+		}
+	}
+
+	if (headless->frames < 1) {
+		headless->frames = 1;
+	}
+}
+
+// Sizes the offscreen framebuffer
+static void ezResizeFramebuffer(const int width, const int height) {
+	struct EzHeadless* headless = &(g_ezCtx.headless);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, headless->colourBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, headless->depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+}
+
+// Creates an EGL context with no window, loads OpenGL, and binds a framebuffer to draw into.
+// Returns EZ_SUCCESS_ERROR_CODE, or the error code to exit with.
+static int ezCreateContext(void) {
+	struct EzHeadless* headless = &(g_ezCtx.headless);
+
+	// prefer Mesa's surfaceless platform, which needs no display server or GPU at all
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	headless->display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) : EGL_NO_DISPLAY;
+
+	if (headless->display == EGL_NO_DISPLAY) {
+		headless->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	if (headless->display == EGL_NO_DISPLAY || !eglInitialize(headless->display, NULL, NULL)) {
+		printf("EGL Failed to Initialise.");
+		return EZ_EGL_INIT_ERROR_CODE;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	// the shaders use gl_FragColor, so ask for a compatibility profile like GLFW gives by default
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+#ifdef EZ_GL_DEBUG
+		EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint configCount;
+	headless->context = EGL_NO_CONTEXT;
+
+	if (eglBindAPI(EGL_OPENGL_API) && eglChooseConfig(headless->display, configAttributes, &config, 1, &configCount) && configCount > 0) {
+		headless->context = eglCreateContext(headless->display, config, EGL_NO_CONTEXT, contextAttributes);
+	}
+
+	if (headless->context == EGL_NO_CONTEXT || !eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless->context)) {
+		printf("EGL Failed to Create a Context.");
+		eglTerminate(headless->display);
+		return EZ_EGL_INIT_ERROR_CODE;
+	}
+
+	if (glewInit() != GLEW_OK) {
+		printf("GLEW Failed to Initialise.");
+		eglDestroyContext(headless->display, headless->context);
+		eglTerminate(headless->display);
+		return EZ_GLEW_INIT_ERROR_CODE;
+	}
+
+	headless->frameTimes = malloc(sizeof(double) * headless->frames);
+
+	if (headless->frameTimes == NULL) {
+		fprintf(stderr, "Ran out of heap memory!\n");
+		eglDestroyContext(headless->display, headless->context);
+		eglTerminate(headless->display);
+		return EZ_OUT_OF_HEAP_MEMORY_ERROR_CODE;
+	}
+
+	// the framebuffer stays bound for the whole run. It's given a size by ezDisplaySize.
+	glGenFramebuffers(1, &(headless->framebuffer));
+	glGenRenderbuffers(1, &(headless->colourBuffer));
+	glGenRenderbuffers(1, &(headless->depthBuffer));
+	ezResizeFramebuffer(1, 1);
+	glBindFramebuffer(GL_FRAMEBUFFER, headless->framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->colourBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->depthBuffer);
+	return EZ_SUCCESS_ERROR_CODE;
+}
+
+static void ezDestroyContext(void) {
+	struct EzHeadless* headless = &(g_ezCtx.headless);
+
+	glDeleteFramebuffers(1, &(headless->framebuffer));
+	glDeleteRenderbuffers(1, &(headless->colourBuffer));
+	glDeleteRenderbuffers(1, &(headless->depthBuffer));
+	free(headless->frameTimes);
+	headless->frameTimes = NULL;
+
+	eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(headless->display, headless->context);
+	eglTerminate(headless->display);
+}
+
+static int ezShouldClose(void) {
+	const struct EzHeadless* headless = &(g_ezCtx.headless);
+	return headless->shouldClose || headless->frame >= headless->frames;
+}
+
+// Saves what has been drawn as a binary PPM image
+static void ezSaveFrame(const int frame) {
+	const int width = g_ezCtx.winWidth;
+	const int height = g_ezCtx.winHeight;
+	unsigned char* pixels = malloc((size_t)width * height * 4);
+
+	if (pixels == NULL) {
+		fprintf(stderr, "Ran out of heap memory!\n");
+		return;
+	}
+
+	ezReadPixels(pixels);
+
+	// PPM has no alpha, so pack the pixels down to RGB
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		memmove(pixels + i * 3, pixels + i * 4, 3);
+	}
+
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "frame_%05d.ppm", frame);
+	FILE* file = fopen(fileName, "wb");
+
+	if (file == NULL) {
+		fprintf(stderr, "Failed to save frame %s\n", fileName);
+		free(pixels);
+		return;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+	// the pixels are bottom row first, PPM is top row first
+	for (int y = height - 1; y >= 0; y--) {
+		fwrite(pixels + (size_t)y * width * 3, 1, (size_t)width * 3, file);
+	}
+
+	fclose(file);
+	free(pixels);
+}
+
+// Records how long the frame took, and saves it if it's due to be dumped
+static void ezPresent(void) {
+	struct EzHeadless* headless = &(g_ezCtx.headless);
+	const EZframestats* stats = &(g_ezCtx.lastStats);
+
+	// wait for the frame to actually be drawn, so the time covers the rendering and not just the submission
+	glFinish();
+	headless->frameTimes[headless->frame] = ezTime() - g_ezCtx.frameStart;
+
+	headless->totals.objects += stats->objects;
+	headless->totals.batches += stats->batches;
+	headless->totals.flushes += stats->flushes;
+	headless->totals.drawCalls += stats->drawCalls;
+	headless->totals.stateCalls += stats->stateCalls;
+	headless->totals.elidedStateCalls += stats->elidedStateCalls;
+	headless->totals.culled += stats->culled;
+
+	if (headless->dumpInterval > 0 && headless->frame % headless->dumpInterval == 0) {
+		ezSaveFrame(headless->frame);
+	}
+
+	headless->frame++;
+}
+
+static void ezPollEvents(void) {
+	// no window, so no events
+}
+
+// Prints the frame times and average frame stats of the run
+static void ezReportHeadless(void) {
+	struct EzHeadless* headless = &(g_ezCtx.headless);
+	const int frames = headless->frame;
+
+	if (frames == 0) {
+		return;
+	}
+
+	double total = 0.0;
+
+	for (int i = 0; i < frames; i++) {
+		total += headless->frameTimes[i];
+	}
+
+	qsort(headless->frameTimes, frames, sizeof(double), ezCompareTimes);
+	const double* sorted = headless->frameTimes;
+
+	printf("Drew %d frames at %dx%d in %.3f s (%.1f fps)\n", frames, g_ezCtx.winWidth, g_ezCtx.winHeight, total, frames / total);
+	printf("Frame time (ms): mean %.3f, min %.3f, median %.3f, 95th %.3f, 99th %.3f, max %.3f\n",
+		total / frames * 1000.0, sorted[0] * 1000.0, sorted[frames / 2] * 1000.0,
+		sorted[frames * 95 / 100] * 1000.0, sorted[frames * 99 / 100] * 1000.0, sorted[frames - 1] * 1000.0);
+	printf("Per frame: %.1f objects, %.1f culled, %.1f batches, %.1f flushes, %.1f draw calls, %.1f state calls, %.1f elided state calls\n",
+		(double)headless->totals.objects / frames, (double)headless->totals.culled / frames, (double)headless->totals.batches / frames,
+		(double)headless->totals.flushes / frames, (double)headless->totals.drawCalls / frames,
+		(double)headless->totals.stateCalls / frames, (double)headless->totals.elidedStateCalls / frames);
+}
+
+#else
+
+static double ezTime(void) {
+	return glfwGetTime();
+}
+
+// Creates the window and loads OpenGL.
+// Returns EZ_SUCCESS_ERROR_CODE, or the error code to exit with.
+static int ezCreateContext(void) {
+	if (!glfwInit()) {
+		printf("GLFW Failed to Initialise.");
+		return EZ_GLFW_INIT_ERROR_CODE;
+	}
+
+	// ezDrawMany relies on the depth buffer to keep objects in order
+	glfwWindowHint(GLFW_DEPTH_BITS, 24);
+#ifdef EZ_GL_DEBUG
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+	g_ezCtx.window = glfwCreateWindow(500, 500, "Window", NULL, NULL);
+	glfwMakeContextCurrent(g_ezCtx.window);
+
+	if (glewInit() != GLEW_OK) {
+		printf("GLEW Failed to Initialise.");
+		glfwDestroyWindow(g_ezCtx.window);
+		glfwTerminate();
+		return EZ_GLEW_INIT_ERROR_CODE;
+	}
+
+	return EZ_SUCCESS_ERROR_CODE;
+}
+
+static void ezDestroyContext(void) {
+	glfwDestroyWindow(g_ezCtx.window);
+	glfwTerminate();
+}
+
+static int ezShouldClose(void) {
+	return glfwWindowShouldClose(g_ezCtx.window);
+}
+
+// Shows the frame
+static void ezPresent(void) {
+	if (g_ezCtx.software.active) {
+		ezShowSoftwareFrame();
+	}
+
+	glfwSwapBuffers(g_ezCtx.window);
+}
+
+// Handles input, running the user's callbacks
+static void ezPollEvents(void) {
+	glfwPollEvents();
+}
+
+#endif
+
+// Tracing
+// Each thread records into its own ring of events, which the render thread writes out to the trace file.
+
+// Gives a thread a ring to record into. Returns NULL if every ring is taken or there's no memory for another.
+static struct EzTraceRing* ezNewTraceRing(const char* threadName) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+	struct EzTraceRing* ring = NULL;
+
+	ezMutexLock(&(tracer->mutex));
+
+	if (tracer->ringCount < EZ_TRACE_MAX_THREADS) {
+		ring = calloc(1, sizeof(struct EzTraceRing));
+
+		if (ring) {
+			ring->threadName = threadName;
+			tracer->rings[tracer->ringCount++] = ring;
+		}
+	}
+
+	ezMutexUnlock(&(tracer->mutex));
+	return ring;
+}
+
+// The calling thread's ring, made the first time it's needed
+static struct EzTraceRing* ezTraceThreadRing(void) {
+	if (t_ezTraceRing == NULL && !t_ezTraceNoRing) {
+		t_ezTraceRing = ezNewTraceRing(t_ezThreadName ? t_ezThreadName : "thread");
+		t_ezTraceNoRing = t_ezTraceRing == NULL;
+	}
+
+	return t_ezTraceRing;
+}
+
+// Adds an event to a ring. Only the ring's own thread may call this. Returns 0 if the ring is full.
+static int ezTracePush(struct EzTraceRing* ring, const char* name, const char phase, const double time, const double duration) {
+	const long head = ring->head;
+	const long next = (head + 1) % EZ_TRACE_RING_EVENTS;
+
+	if (next == ezAtomicLoad(&(ring->tail))) {
+		ezAtomicStore(&(ring->dropped), ring->dropped + 1);
+		return 0;
+	}
+
+	struct EzTraceEvent* event = &(ring->events[head]);
+	event->name = name;
+	event->phase = phase;
+	event->time = time;
+	event->duration = duration;
+
+	// publish the event only once it's written
+	ezAtomicStore(&(ring->head), next);
+	return 1;
+}
+
+// Records something on the calling thread that started and ended at the given ezTime()s
+static void ezTraceComplete(const char* name, const double start, const double end) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	if (ezAtomicLoad(&(tracer->recording))) {
+		struct EzTraceRing* ring = ezTraceThreadRing();
+
+		if (ring) {
+			ezTracePush(ring, name, 'X', (start - tracer->start) * 1000000.0, (end - start) * 1000000.0);
+		}
+	}
+}
+
+// Records something the GPU did between two GL_TIMESTAMPs, on the GPU's row. Render thread only.
+static void ezTraceGpu(const char* name, const long long start, const long long end) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	// skip anything from before tracing started
+	if (!ezAtomicLoad(&(tracer->recording)) || start < tracer->gpuStart) {
+		return;
+	}
+
+	if (tracer->gpuRing == NULL) {
+		tracer->gpuRing = ezNewTraceRing("GPU");
+
+		if (tracer->gpuRing == NULL) return;
+	}
+
+	ezTracePush(tracer->gpuRing, name, 'X', (double)(start - tracer->gpuStart) / 1000.0, (double)(end - start) / 1000.0);
+}
+
+void ezTraceBegin(const char* name) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+	const int depth = t_ezTraceDepth++;
+	int recorded = 0;
+
+	if (depth >= EZ_TRACE_MAX_DEPTH) {
+		return;
+	}
+
+	t_ezTraceNames[depth] = name;
+
+	if (ezAtomicLoad(&(tracer->recording))) {
+		struct EzTraceRing* ring = ezTraceThreadRing();
+		recorded = ring && ezTracePush(ring, name, 'B', (ezTime() - tracer->start) * 1000000.0, 0.0);
+	}
+
+	// remember whether to record the end, so traces never have an end without a beginning
+	if (recorded) {
+		t_ezTraceRecorded |= 1ull << depth;
+	} else {
+		t_ezTraceRecorded &= ~(1ull << depth);
+	}
+}
+
+void ezTraceEnd(void) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	if (t_ezTraceDepth == 0) {
+		fprintf(stderr, "ezTraceEnd called without a matching ezTraceBegin\n");
+		return;
+	}
+
+	const int depth = --t_ezTraceDepth;
+
+	if (depth < EZ_TRACE_MAX_DEPTH && (t_ezTraceRecorded & (1ull << depth)) && ezAtomicLoad(&(tracer->recording))) {
+		ezTracePush(t_ezTraceRing, NULL, 'E', (ezTime() - tracer->start) * 1000000.0, 0.0);
+	}
+}
+
+// Writes a string to the trace file as a JSON string
+static void ezTraceWriteString(FILE* file, const char* string) {
+	fputc('"', file);
+
+	for (const unsigned char* c = (const unsigned char*)string; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fprintf(file, "\\%c", *c);
+		} else if (*c < 0x20) {
+			fprintf(file, "\\u%04x", *c);
+		} else {
+			fputc(*c, file);
+		}
+	}
+
+	fputc('"', file);
+}
+
+// Writes out everything in a ring. Must hold the tracer mutex.
+static void ezTraceWriteRing(struct EzTraceRing* ring, const int thread) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+	FILE* file = tracer->file;
+	long tail = ring->tail;
+	const long head = ezAtomicLoad(&(ring->head));
+
+	if (tail == head) {
+		return;
+	}
+
+	if (!ring->named) {
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", tracer->written ? ",\n" : "", thread);
+		ezTraceWriteString(file, ring->threadName);
+		fprintf(file, "}}");
+		ring->named = 1;
+		tracer->written = 1;
+	}
+
+	while (tail != head) {
+		const struct EzTraceEvent* event = &(ring->events[tail]);
+
+		fprintf(file, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f", event->phase, thread, event->time);
+
+		if (event->phase == 'X') {
+			fprintf(file, ",\"dur\":%.3f", event->duration);
+		}
+
+		if (event->name) {
+			fprintf(file, ",\"name\":");
+			ezTraceWriteString(file, event->name);
+		}
+
+		fputc('}', file);
+		tail = (tail + 1) % EZ_TRACE_RING_EVENTS;
+	}
+
+	// hand the space back to the thread only once the events have been copied out
+	ezAtomicStore(&(ring->tail), tail);
+}
+
+void ezTraceFlush(void) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	if (tracer->file == NULL) {
+		return;
+	}
+
+	ezMutexLock(&(tracer->mutex));
+
+	for (int i = 0; i < tracer->ringCount; i++) {
+		ezTraceWriteRing(tracer->rings[i], i + 1);
+	}
+
+	ezMutexUnlock(&(tracer->mutex));
+	fflush(tracer->file);
+}
+
+int ezTraceStart(const char* fileName) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	ezTraceStop();
+	tracer->file = fopen(fileName, "w");
+
+	if (tracer->file == NULL) {
+		fprintf(stderr, "Failed to open trace file %s\n", fileName);
+		return 0;
+	}
+
+	fprintf(tracer->file, "[\n");
+	tracer->written = 0;
+	tracer->start = ezTime();
+	tracer->gpuStart = 0;
+
+	if (g_ezCtx.gpuTimer.supported) {
+		GLint64 now;
+		glGetInteger64v(GL_TIMESTAMP, &now);
+		tracer->gpuStart = now;
+	}
+
+	// throw away anything left over from the last trace
+	ezMutexLock(&(tracer->mutex));
+
+	for (int i = 0; i < tracer->ringCount; i++) {
+		struct EzTraceRing* ring = tracer->rings[i];
+		ezAtomicStore(&(ring->tail), ezAtomicLoad(&(ring->head)));
+		ring->named = 0;
+		ring->droppedBefore = ezAtomicLoad(&(ring->dropped));
+	}
+
+	ezMutexUnlock(&(tracer->mutex));
+
+	ezAtomicStore(&(tracer->recording), 1);
+	return EZ_OK;
+}
+
+void ezTraceStop(void) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	if (tracer->file == NULL) {
+		return;
+	}
+
+	ezAtomicStore(&(tracer->recording), 0);
+	ezTraceFlush();
+
+	fprintf(tracer->file, "\n]\n");
+	fclose(tracer->file);
+	tracer->file = NULL;
+
+	long dropped = 0;
+
+	for (int i = 0; i < tracer->ringCount; i++) {
+		dropped += ezAtomicLoad(&(tracer->rings[i]->dropped)) - tracer->rings[i]->droppedBefore;
+	}
+
+	if (dropped) {
+		fprintf(stderr, "%ld trace events were dropped because they were recorded faster than they could be written. Try calling ezTraceFlush more often.\n", dropped);
+	}
+}
+
+// Writes out the trace if any thread's ring is getting full. Called at the end of each frame.
+static void ezTraceEndFrame(void) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	if (tracer->file == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < tracer->ringCount; i++) {
+		struct EzTraceRing* ring = tracer->rings[i];
+		const long used = (ezAtomicLoad(&(ring->head)) - ring->tail + EZ_TRACE_RING_EVENTS) % EZ_TRACE_RING_EVENTS;
+
+		if (used > EZ_TRACE_RING_EVENTS / 2) {
+			ezTraceFlush();
+			return;
+		}
+	}
+}
+
+static void ezInitTrace(void) {
+	ezMutexInit(&(g_ezCtx.tracer.mutex));
+	t_ezThreadName = "render thread";
+}
+
+// Finishes the trace file and frees every ring. Every other thread must have stopped.
+static void ezFreeTrace(void) {
+	struct EzTracer* tracer = &(g_ezCtx.tracer);
+
+	ezTraceStop();
+
+	for (int i = 0; i < tracer->ringCount; i++) {
+		free(tracer->rings[i]);
+	}
+
+	tracer->ringCount = 0;
+	tracer->gpuRing = NULL;
+	t_ezTraceRing = NULL;
+	ezMutexDestroy(&(tracer->mutex));
+}
+
+// Profiler
+// Times each phase of every frame, keeping the last EZ_PROFILE_FRAMES frames.
+
+// Width of each frame's bar in the overlay graph, in pixels
+#define EZ_OVERLAY_BAR_WIDTH 2
+// Number of frames shown in the overlay graph
+#define EZ_OVERLAY_BARS 128
+// Height of a millisecond in the overlay graph, in pixels
+#define EZ_OVERLAY_PIXELS_PER_MS 3.0f
+#define EZ_OVERLAY_GRAPH_HEIGHT 100.0f
+
+// Names of the phases in traces and error reports, in the order of EZ_PHASE_*
+static const char* g_ezPhaseNames[EZ_PHASE_COUNT] = { "clear", "upload images", "draw", "submit", "present", "poll events" };
+
+// Starts timing the first phase of a frame
+static void ezProfileStartFrame(void) {
+	g_ezCtx.profiler.mark = g_ezCtx.frameStart;
+	g_ezCtx.profiler.phaseName = g_ezPhaseNames[0];
+}
+
+// Ends a phase of the frame, which started when the last one ended
+static void ezProfilePhase(const int phase) {
+	struct EzProfiler* profiler = &(g_ezCtx.profiler);
+	const double now = ezTime();
+
+	ezTraceComplete(g_ezPhaseNames[phase], profiler->mark, now);
+	profiler->current[phase] = now - profiler->mark;
+	profiler->mark = now;
+	profiler->phaseName = phase + 1 < EZ_PHASE_COUNT ? g_ezPhaseNames[phase + 1] : NULL;
+}
+
+// Finishes timing the frame and moves on to the next slot in the history
+static void ezProfileEndFrame(void) {
+	struct EzProfiler* profiler = &(g_ezCtx.profiler);
+
+	ezTraceComplete("frame", g_ezCtx.frameStart, profiler->mark);
+	memcpy(profiler->phases[profiler->head], profiler->current, sizeof(profiler->current));
+	profiler->frames[profiler->head] = profiler->mark - g_ezCtx.frameStart;
+	profiler->head = (profiler->head + 1) % EZ_PROFILE_FRAMES;
+
+	if (profiler->count < EZ_PROFILE_FRAMES) {
+		profiler->count++;
+	}
+}
+
+// Works out the min, mean, 99th percentile and max of some times in seconds, giving them in milliseconds
+static void ezSummariseTimes(double* times, const int count, EZtimingstats* stats) {
+	double total = 0.0;
+
+	for (int i = 0; i < count; i++) {
+		total += times[i];
+	}
+
+	qsort(times, count, sizeof(double), ezCompareTimes);
+
+	stats->min = times[0] * 1000.0;
+	stats->avg = total / count * 1000.0;
+	stats->p99 = times[count * 99 / 100] * 1000.0;
+	stats->max = times[count - 1] * 1000.0;
+}
+
+void ezGetProfile(EZprofile* profile) {
+	const struct EzProfiler* profiler = &(g_ezCtx.profiler);
+	double times[EZ_PROFILE_FRAMES];
+
+	memset(profile, 0, sizeof(EZprofile));
+	profile->frames = profiler->count;
+
+	if (profiler->count == 0) {
+		return;
+	}
+
+	for (int i = 0; i < profiler->count; i++) {
+		int bucket = (int)(profiler->frames[i] * 1000.0 / EZ_PROFILE_BUCKET_MS);
+
+		if (bucket >= EZ_PROFILE_BUCKETS) {
+			bucket = EZ_PROFILE_BUCKETS - 1;
+		}
+
+		profile->histogram[bucket]++;
+	}
+
+	memcpy(times, profiler->frames, sizeof(double) * profiler->count);
+	ezSummariseTimes(times, profiler->count, &(profile->frame));
+
+	for (int phase = 0; phase < EZ_PHASE_COUNT; phase++) {
+		for (int i = 0; i < profiler->count; i++) {
+			times[i] = profiler->phases[i][phase];
+		}
+
+		ezSummariseTimes(times, profiler->count, &(profile->phases[phase]));
+	}
+}
+
+void ezSetProfilerOverlay(int enabled) {
+	g_ezCtx.profiler.overlay = enabled;
+}
+
+// Defined with the rest of the draw functions
+static int ezDrawSlot(const int slot);
+// Defined with the rest of the camera code
+static void ezSetCamera(const struct EzCamera* camera);
+
+// Draws a rectangle for the overlay. One object is moved around to draw every rectangle, as each draw copies it.
+static void ezOverlayRect(const float x, const float y, const float width, const float height, const float r, const float g, const float b) {
+	EZobject* rect = g_ezCtx.profiler.overlayRect;
+
+	ezMove(rect, x, y);
+	ezResize(rect, width, height);
+	ezColour(rect, r, g, b);
+	// not something the program drew, so it can't be picked
+	ezDrawSlot(ezObjectSlot(rect));
+}
+
+// Draws a number with one decimal place as seven segment digits, from the bottom left
+static void ezOverlayNumber(float x, const float y, const double value, const float r, const float g, const float b) {
+	// segments lit for each digit, as bits: top, top right, bottom right, bottom, bottom left, top left, middle
+	static const unsigned char digits[10] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F };
+	// where each segment is in an 8x14 digit: x, y, width, height
+	static const float segments[7][4] = {
+		{ 0, 12, 8, 2 }, { 6, 7, 2, 7 }, { 6, 0, 2, 7 }, { 0, 0, 8, 2 }, { 0, 0, 2, 7 }, { 0, 7, 2, 7 }, { 0, 6, 8, 2 }
+	};
+
+	char text[16];
+	snprintf(text, sizeof(text), "%.1f", value);
+
+	for (const char* c = text; *c; c++) {
+		if (*c == '.') {
+			ezOverlayRect(x, y, 2, 2, r, g, b);
+			x += 5;
+		} else if (*c >= '0' && *c <= '9') {
+			for (int segment = 0; segment < 7; segment++) {
+				if (digits[*c - '0'] & (1 << segment)) {
+					ezOverlayRect(x + segments[segment][0], y + segments[segment][1], segments[segment][2], segments[segment][3], r, g, b);
+				}
+			}
+
+			x += 11;
+		}
+	}
+}
+
+// Draws a graph of recent frame times, split by phase, with the mean and 99th percentile frame time above it
+static void ezDrawProfilerOverlay(void) {
+	struct EzProfiler* profiler = &(g_ezCtx.profiler);
+	// colours of the phases in the graph, in the order of EZ_PHASE_*
+	static const float colours[EZ_PHASE_COUNT][3] = {
+		{ 0.5f, 0.5f, 0.5f }, { 0.7f, 0.3f, 0.9f }, { 0.2f, 0.8f, 0.2f }, { 0.9f, 0.8f, 0.1f }, { 0.9f, 0.3f, 0.2f }, { 0.2f, 0.5f, 0.9f }
+	};
+
+	if (profiler->overlayRect == NULL) {
+		profiler->overlayRect = ezCreateRect(1.0f, 1.0f);
+
+		if (profiler->overlayRect == NULL) {
+			return;
+		}
+	}
+
+	const float left = 8.0f;
+	const float bottom = 8.0f;
+	const float graphWidth = (float)(EZ_OVERLAY_BARS * EZ_OVERLAY_BAR_WIDTH);
+
+	// drawn straight onto the window, wherever the camera is
+	const struct EzCamera camera = g_ezCtx.camera;
+	struct EzCamera window = { 0 };
+	window.zoom = 1.0f;
+	window.cosine = 1.0;
+	ezSetCamera(&window);
+
+	// background
+	ezOverlayRect(left, bottom, graphWidth + 8.0f, EZ_OVERLAY_GRAPH_HEIGHT + 30.0f, 0.1f, 0.1f, 0.1f);
+
+	// one stacked bar per frame, oldest on the left
+	const int bars = profiler->count < EZ_OVERLAY_BARS ? profiler->count : EZ_OVERLAY_BARS;
+
+	for (int i = 0; i < bars; i++) {
+		const int frame = (profiler->head - bars + i + EZ_PROFILE_FRAMES) % EZ_PROFILE_FRAMES;
+		const float x = left + 4.0f + (float)((EZ_OVERLAY_BARS - bars + i) * EZ_OVERLAY_BAR_WIDTH);
+		float y = 0.0f;
+
+		for (int phase = 0; phase < EZ_PHASE_COUNT && y < EZ_OVERLAY_GRAPH_HEIGHT; phase++) {
+			float height = (float)(profiler->phases[frame][phase] * 1000.0) * EZ_OVERLAY_PIXELS_PER_MS;
+
+			if (y + height > EZ_OVERLAY_GRAPH_HEIGHT) {
+				height = EZ_OVERLAY_GRAPH_HEIGHT - y;
+			}
+
+			if (height >= 0.5f) {
+				ezOverlayRect(x, bottom + 4.0f + y, (float)EZ_OVERLAY_BAR_WIDTH, height, colours[phase][0], colours[phase][1], colours[phase][2]);
+			}
+
+			y += height;
+		}
+	}
+
+	// lines at 60 and 30 frames per second
+	ezOverlayRect(left + 4.0f, bottom + 4.0f + 16.7f * EZ_OVERLAY_PIXELS_PER_MS, graphWidth, 1.0f, 0.8f, 0.8f, 0.8f);
+	ezOverlayRect(left + 4.0f, bottom + 4.0f + 33.3f * EZ_OVERLAY_PIXELS_PER_MS, graphWidth, 1.0f, 0.8f, 0.8f, 0.8f);
+
+	if (profiler->count > 0) {
+		EZprofile profile;
+		ezGetProfile(&profile);
+
+		const float textY = bottom + EZ_OVERLAY_GRAPH_HEIGHT + 10.0f;
+		ezOverlayNumber(left + 4.0f, textY, profile.frame.avg, 1.0f, 1.0f, 1.0f);
+		ezOverlayNumber(left + 4.0f + graphWidth / 2.0f, textY, profile.frame.p99, 1.0f, 0.4f, 0.4f);
+	}
+
+	ezSetCamera(&camera);
+}
+
+// GPU Timing
+// Timestamps are read back a few frames after they're issued, once the GPU has reached them, so reading never stalls.
+
+// Creates the timestamp queries, if the driver supports them
+static void ezInitGpuTimer(void) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+	GLint bits = 0;
+
+	// part of OpenGL 3.3, but some drivers report a zero bit counter when they can't actually time anything
+	if (GLEW_ARB_timer_query) {
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	}
+
+	timer->supported = bits > 0;
+
+	if (timer->supported) {
+		glGenQueries(EZ_GPU_TIMER_FRAMES * EZ_GPU_MAX_STAMPS, &(timer->queries[0][0]));
+	}
+}
+
+static void ezFreeGpuTimer(void) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+
+	if (timer->supported) {
+		glDeleteQueries(EZ_GPU_TIMER_FRAMES * EZ_GPU_MAX_STAMPS, &(timer->queries[0][0]));
+		timer->supported = 0;
+	}
+}
+
+static void ezGpuStamp(const int kind, const char* name) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+	const int frame = timer->current;
+
+	if (!timer->supported || !timer->pending[frame]) {
+		return;
+	}
+
+	// room is always kept for the start, clear, submit and present, so any batches past the limit are timed as part of the next stamp
+	if (kind == EZ_GPU_STAMP_BATCH) {
+		if (timer->batches == EZ_GPU_MAX_BATCHES) return;
+		timer->batches++;
+	}
+
+	const int stamp = timer->counts[frame]++;
+	glQueryCounter(timer->queries[frame][stamp], GL_TIMESTAMP);
+	timer->kinds[frame][stamp] = kind;
+	timer->names[frame][stamp] = name;
+}
+
+// Turns a frame's timestamps into results
+static void ezReadGpuFrame(const int frame) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+	EZgpustats* stats = &(timer->last);
+	GLuint64 times[EZ_GPU_MAX_STAMPS];
+	// stamps of the scopes still open at each point
+	int open[EZ_GPU_MAX_SCOPES];
+	int depth = 0;
+	double clear = 0.0;
+	double submit = 0.0;
+
+	for (int i = 0; i < timer->counts[frame]; i++) {
+		glGetQueryObjectui64v(timer->queries[frame][i], GL_QUERY_RESULT, &times[i]);
+	}
+
+	memset(stats, 0, sizeof(EZgpustats));
+	stats->available = 1;
+	stats->droppedFrames = timer->dropped;
+	timer->dropped = 0;
+
+	for (int i = 1; i < timer->counts[frame]; i++) {
+		// nanoseconds to milliseconds
+		const double since = (double)(times[i] - times[0]) / 1000000.0;
+		const double elapsed = (double)(times[i] - times[i - 1]) / 1000000.0;
+
+		switch (timer->kinds[frame][i]) {
+		case EZ_GPU_STAMP_CLEAR:
+			stats->clear = elapsed;
+			clear = since;
+			break;
+		case EZ_GPU_STAMP_BATCH:
+			stats->batchTimes[stats->batches++] = elapsed;
+			break;
+		case EZ_GPU_STAMP_SCOPE_BEGIN:
+			open[depth++] = stats->scopes;
+			stats->scopeTimes[stats->scopes].name = timer->names[frame][i];
+			stats->scopeTimes[stats->scopes].time = since;
+			stats->scopes++;
+			break;
+		case EZ_GPU_STAMP_SCOPE_END:
+			depth--;
+			stats->scopeTimes[open[depth]].time = since - stats->scopeTimes[open[depth]].time;
+			break;
+		case EZ_GPU_STAMP_SUBMIT:
+			submit = since;
+			stats->draw = submit - clear;
+			break;
+		case EZ_GPU_STAMP_PRESENT:
+			stats->present = since - submit;
+			stats->frame = since;
+			break;
+		}
+	}
+
+	// the same times again for the trace, on the GPU's row
+	for (int i = 1; i < timer->counts[frame]; i++) {
+		const long long start = (long long)times[i - 1];
+		const long long end = (long long)times[i];
+
+		switch (timer->kinds[frame][i]) {
+		case EZ_GPU_STAMP_CLEAR:
+			ezTraceGpu("clear", start, end);
+			break;
+		case EZ_GPU_STAMP_BATCH:
+			ezTraceGpu("batch", start, end);
+			break;
+		case EZ_GPU_STAMP_PRESENT:
+			ezTraceGpu("present", start, end);
+			ezTraceGpu("frame", (long long)times[0], end);
+			break;
+		}
+	}
+
+	for (int i = 0, scope = 0; i < timer->counts[frame]; i++) {
+		if (timer->kinds[frame][i] == EZ_GPU_STAMP_SCOPE_BEGIN) {
+			const EZgpuscope* result = &(stats->scopeTimes[scope++]);
+			ezTraceGpu(result->name, (long long)times[i], (long long)times[i] + (long long)(result->time * 1000000.0));
+		}
+	}
+
+	timer->pending[frame] = 0;
+}
+
+// Reads any finished frames, then starts recording a new one
+static void ezGpuStartFrame(void) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+
+	if (!timer->supported) {
+		return;
+	}
+
+	// oldest first, stopping at the first the GPU hasn't finished, so results only ever move forwards
+	for (int age = EZ_GPU_TIMER_FRAMES - 1; age >= 1; age--) {
+		const int frame = (timer->current + EZ_GPU_TIMER_FRAMES - age) % EZ_GPU_TIMER_FRAMES;
+
+		if (!timer->pending[frame]) {
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(timer->queries[frame][timer->counts[frame] - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available) {
+			break;
+		}
+
+		ezReadGpuFrame(frame);
+	}
+
+	timer->current = (timer->current + 1) % EZ_GPU_TIMER_FRAMES;
+
+	// the GPU is more than a few frames behind. Rather than wait, give up on the oldest frame.
+	if (timer->pending[timer->current]) {
+		timer->dropped++;
+	}
+
+	timer->counts[timer->current] = 0;
+	timer->pending[timer->current] = 1;
+	timer->batches = 0;
+	timer->scopes = 0;
+	timer->depth = 0;
+	timer->untimed = 0;
+	ezGpuStamp(EZ_GPU_STAMP_START, NULL);
+}
+
+// Marks the end of the frame's drawing. Scopes left open are closed here.
+static void ezGpuSubmitted(void) {
+	while (g_ezCtx.gpuTimer.depth > 0) {
+		ezGpuScopeEnd();
+	}
+
+	ezGpuStamp(EZ_GPU_STAMP_SUBMIT, NULL);
+}
+
+void ezGpuScopeBegin(const char* name) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+
+	// drawing queued before the scope began shouldn't count towards it
+	ezFlushBatch();
+
+	timer->depth++;
+
+	// too many: the scope's time goes to whatever scope it's in
+	if (timer->scopes == EZ_GPU_MAX_SCOPES) {
+		timer->untimed++;
+		return;
+	}
+
+	timer->scopes++;
+	ezGpuStamp(EZ_GPU_STAMP_SCOPE_BEGIN, name);
+}
+
+void ezGpuScopeEnd(void) {
+	struct EzGpuTimer* timer = &(g_ezCtx.gpuTimer);
+
+	if (timer->depth == 0) {
+		fprintf(stderr, "ezGpuScopeEnd called without a matching ezGpuScopeBegin\n");
+		return;
+	}
+
+	ezFlushBatch();
+	timer->depth--;
+
+	if (timer->untimed > 0) {
+		timer->untimed--;
+	} else {
+		ezGpuStamp(EZ_GPU_STAMP_SCOPE_END, NULL);
+	}
+}
+
+void ezGetGpuStats(EZgpustats* stats) {
+	*stats = g_ezCtx.gpuTimer.last;
+}
+
+// Debug Output
+// OpenGL reports errors through a KHR_debug callback where it can, so nothing has to wait on the driver to find them.
+
+// Where the render thread is: its innermost traced scope, or else the phase of the frame
+static const char* ezCallSite(void) {
+	if (t_ezTraceDepth > 0 && t_ezTraceDepth <= EZ_TRACE_MAX_DEPTH) {
+		return t_ezTraceNames[t_ezTraceDepth - 1];
+	}
+
+	return g_ezCtx.profiler.phaseName ? g_ezCtx.profiler.phaseName : "outside the main loop";
+}
+
+// Passes a message on to the program's error function, or prints it if there isn't one
+static void ezReportOpenGLError(const int severity, const char* message, const char* callSite) {
+	if (g_ezCtx.glErrorFun) {
+		g_ezCtx.glErrorFun(severity, message, callSite);
+	} else {
+		fprintf(stderr, "OpenGL (%s): %s\n", callSite ? callSite : "unknown call site", message);
+	}
+}
+
+static void GLAPIENTRY ezDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user) {
+	(void)source; (void)type; (void)id; (void)length; (void)user;
+	int ezSeverity;
+
+	switch (severity) {
+	case GL_DEBUG_SEVERITY_HIGH: ezSeverity = EZ_GL_SEVERITY_HIGH; break;
+	case GL_DEBUG_SEVERITY_MEDIUM: ezSeverity = EZ_GL_SEVERITY_MEDIUM; break;
+	case GL_DEBUG_SEVERITY_LOW: ezSeverity = EZ_GL_SEVERITY_LOW; break;
+	default: ezSeverity = EZ_GL_SEVERITY_NOTIFICATION; break;
+	}
+
+	// asynchronous messages arrive later, possibly on one of the driver's threads, so where they came from is unknown
+	ezReportOpenGLError(ezSeverity, message, g_ezCtx.debugOutput.synchronous ? ezCallSite() : NULL);
+}
+
+// Tells the driver which severities to report, so the rest are dropped before they reach the callback
+static void ezApplyDebugSeverity(void) {
+	static const GLenum severities[4] = { GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH };
+
+	for (int i = 0; i < 4; i++) {
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severities[i], 0, NULL, i >= g_ezCtx.debugOutput.minSeverity ? GL_TRUE : GL_FALSE);
+	}
+}
+
+// Installs the debug message callback, if the driver has one
+static void ezInitDebugOutput(void) {
+	struct EzDebugOutput* debugOutput = &(g_ezCtx.debugOutput);
+
+	debugOutput->available = GLEW_KHR_debug;
+	debugOutput->minSeverity = EZ_GL_SEVERITY_MEDIUM;
+#ifdef EZ_GL_DEBUG
+	debugOutput->synchronous = 1;
+#else
+	debugOutput->synchronous = 0;
+#endif
+
+	if (!debugOutput->available) {
+		return;
+	}
+
+	glDebugMessageCallback(ezDebugMessage, NULL);
+	glEnable(GL_DEBUG_OUTPUT);
+
+	if (debugOutput->synchronous) {
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	}
+
+	ezApplyDebugSeverity();
+}
+
+// Reports errors the old way, on drivers without KHR_debug. Only done if the program wants to hear about them,
+// since glGetError makes the CPU wait for the driver to catch up.
+static void ezPollOpenGLErrors(void) {
+	if (g_ezCtx.debugOutput.available || g_ezCtx.glErrorFun == NULL) {
+		return;
+	}
+
+	GLenum error;
+	// glGetError returns each error flag once, and there are only a handful of them
+	int limit = 8;
+
+	while ((error = glGetError()) != GL_NO_ERROR && limit-- > 0) {
+		char message[64];
+		snprintf(message, sizeof(message), "GL error 0x%04X", error);
+		ezReportOpenGLError(EZ_GL_SEVERITY_HIGH, message, "frame");
+	}
+}
+
+void ezSetOpenGLErrorFunction(EZglerrorfun function) {
+	g_ezCtx.glErrorFun = function;
+}
+
+void ezSetOpenGLDebugSeverity(int minSeverity) {
+	g_ezCtx.debugOutput.minSeverity = minSeverity;
+
+	if (g_ezCtx.debugOutput.available) {
+		ezApplyDebugSeverity();
+	}
+}
+
+void ezSetOpenGLDebugSynchronous(int synchronous) {
+	g_ezCtx.debugOutput.synchronous = synchronous;
+
+	if (g_ezCtx.debugOutput.available) {
+		if (synchronous) {
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		} else {
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		}
+	}
+}
+
+// Window
+
+void ezTitle(const char* title) {
+#ifndef EZ_HEADLESS
+	glfwSetWindowTitle(g_ezCtx.window, title);
+#else
+	// no window to give it to
+	(void)title;
+#endif
+}
+
+void ezDisplaySize(const int width, const int height) {
+	// objects already drawn this frame were positioned for the old size
+	ezFlushBatch();
+
+	g_ezCtx.winWidth = width;
+	g_ezCtx.winHeight = height;
+#ifdef EZ_HEADLESS
+	ezResizeFramebuffer(width, height);
+#else
+	glfwSetWindowSize(g_ezCtx.window, width, height);
+#endif
+	glViewport(0, 0, width, height); // tell gl to adapt accordingly
+
+	if (g_ezCtx.software.active && !ezSoftwareResize(width, height)) {
+		fprintf(stderr, "Ran out of heap memory! Switching back to OpenGL rendering.\n");
+		g_ezCtx.software.active = 0;
+		g_ezCtx.software.requested = EZ_RENDERER_OPENGL;
+	}
+	// each shader variant picks up the new size the next time it's used
+}
+
+void ezSetShouldClose(void) {
+#ifdef EZ_HEADLESS
+	g_ezCtx.headless.shouldClose = 1;
+#else
+	glfwSetWindowShouldClose(g_ezCtx.window, 1);
+#endif
+}
+
+int ezGetWidth(void) {
+	return g_ezCtx.winWidth;
+}
+
+int ezGetHeight(void) {
+	return g_ezCtx.winHeight;
+}
+
+// Callbacks: Impl (GLFW event handlers)
+// There are no events in headless builds, so the functions are only stored.
+
+#ifndef EZ_HEADLESS
+
+static void ezKeyHook(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (g_ezCtx.keyFun) {
+		g_ezCtx.keyFun(key, action);
+	}
+}
+
+static void ezResizeHook(GLFWwindow* window, int width, int height) {
+	ezDisplaySize(width, height);
+
+	if (g_ezCtx.resizeFun) {
+		g_ezCtx.resizeFun(width, height);
+	}
+}
+
+static void ezMouseHook(GLFWwindow* window, double mouseX, double mouseY) {
+	if (g_ezCtx.mouseFun) {
+		g_ezCtx.mouseFun(mouseX, (double)g_ezCtx.winHeight - mouseY);
+	}
+}
+
+static void ezClickHook(GLFWwindow* window, int button, int action, int mods) {
+	if (g_ezCtx.clickFun) {
+		g_ezCtx.clickFun(button, action);
+	}
+}
+#endif
+
+// Callbacks: API
+
+void ezSetKeyFunction(EZkeyfun function) {
+	g_ezCtx.keyFun = function;
+#ifndef EZ_HEADLESS
+	glfwSetKeyCallback(g_ezCtx.window, ezKeyHook);
+#endif
+}
+
+void ezSetMouseMoveFunction(EZmousefun function) {
+	g_ezCtx.mouseFun = function;
+#ifndef EZ_HEADLESS
+	glfwSetCursorPosCallback(g_ezCtx.window, ezMouseHook);
+#endif
+}
+
+void ezSetClickFunction(EZclickfun function) {
+	g_ezCtx.clickFun = function;
+#ifndef EZ_HEADLESS
+	glfwSetMouseButtonCallback(g_ezCtx.window, ezClickHook);
+#endif
+}
+
+void ezSetResizeFunction(EZresizefun function) {
+	g_ezCtx.resizeFun = function;
+#ifndef EZ_HEADLESS
+	glfwSetWindowSizeCallback(g_ezCtx.window, ezResizeHook);
+#endif
+}
+
+void ezSetOutOfMemoryFunction(EZmemerrfun function) {
+	g_ezCtx.memErrFun = function;
+}
+
+// Object Functions
+
+// Notes that an object has changed, so the next ezDrawScene uploads it again if it's in the scene.
+// restructure is set for changes that can move it into a different draw call: to its texture or its edges.
+static void ezSceneChanged(const int slot, const int restructure);
+
+// Takes the object in a pool slot out of the scene, if it's in it
+static void ezSceneRemoveSlot(const int slot);
+
+EZobject* ezCreateRect(float width, float height) {
+	struct EzObjectPool* pool = &(g_ezCtx.objects);
+
+	// only allocate when there's no free slot left to reuse
+	if (pool->freeHead == -1 && pool->capacity < EZ_POOL_MAX_OBJECTS) {
+		int capacity = pool->capacity ? pool->capacity * 2 : EZ_POOL_INITIAL_CAPACITY;
+
+		if (capacity > EZ_POOL_MAX_OBJECTS) {
+			capacity = EZ_POOL_MAX_OBJECTS;
+		}
+
+		// leaves the free list empty on failure
+		ezGrowPool(capacity);
+	}
+
+	if (pool->freeHead == -1) {
+		fprintf(stderr, "Ran out of heap memory!\n");
+		int shouldExit = 1;
+
+		if (g_ezCtx.memErrFun) {
+			shouldExit = g_ezCtx.memErrFun();
+		}
+
+		if (shouldExit) {
+			cleanup();
+			exit(EZ_OUT_OF_HEAP_MEMORY_ERROR_CODE);
+		}
+
+		return NULL;
+	}
+
+	// take a slot off the free list
+	const int slot = pool->freeHead;
+	pool->freeHead = pool->nextFree[slot];
+	pool->nextFree[slot] = EZ_SLOT_IN_USE;
+
+	if (pool->freeHead == -1) {
+		pool->freeTail = -1;
+	}
+
+	// Set colour to white
+	pool->r[slot] = 1.0f;
+	pool->b[slot] = 1.0f;
+	pool->g[slot] = 1.0f;
+
+	// Set position
+	pool->x[slot] = 0.0;
+	pool->y[slot] = 0.0;
+
+	pool->anchorX[slot] = 0.0f;
+	pool->anchorY[slot] = 0.0f;
+
+	// Set data used for fillet
+	pool->width[slot] = width;
+	pool->height[slot] = height;
+	memset(pool->radii[slot], 0, sizeof(pool->radii[slot]));
+
+	// upright and unstretched
+	pool->rotation[slot] = 0.0f;
+	pool->scaleX[slot] = 1.0f;
+	pool->scaleY[slot] = 1.0f;
+
+	// no border
+	pool->borderWidth[slot] = 0.0f;
+	memset(pool->borderColour[slot], 0, sizeof(pool->borderColour[slot]));
+
+	// default texture
+	pool->texture[slot] = 0;
+
+	// only in the scene once it's added
+	pool->sceneIndex[slot] = -1;
+
+	// no GL buffers here: every object is drawn as an instance of the shared unit quad
+	return ezMakeHandle(slot);
+}
+
+EZobject* ezCreateCircle(float radius) {
+	// create object via ezCreateRect
+	EZobject* result = ezCreateRect(radius * 2, radius * 2);
+	// anchor in centre
+	ezAnchor(result, 0.5f, 0.5f);
+	// set fillet
+	ezFilletRadius(result, radius);
+	// return
+	return result;
+}
+
+void ezAnchor(EZobject* object, float x, float y) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	g_ezCtx.objects.anchorX[slot] = x;
+	g_ezCtx.objects.anchorY[slot] = y;
+	ezSceneChanged(slot, 0);
+}
+
+void ezMove(EZobject* object, double x, double y) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	g_ezCtx.objects.x[slot] = x;
+	g_ezCtx.objects.y[slot] = y;
+	ezSceneChanged(slot, 0);
+}
+
+void ezResize(EZobject* object, float width, float height) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	// the quad is scaled in the vertex shader, so there's no buffer data to update
+	g_ezCtx.objects.width[slot] = width;
+	g_ezCtx.objects.height[slot] = height;
+	ezSceneChanged(slot, 0);
+}
+
+void ezRotate(EZobject* object, float radians) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	// turned in the vertex shader, like the quad is scaled
+	g_ezCtx.objects.rotation[slot] = radians;
+	ezSceneChanged(slot, 0);
+}
+
+void ezScale(EZobject* object, float x, float y) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	g_ezCtx.objects.scaleX[slot] = x;
+	g_ezCtx.objects.scaleY[slot] = y;
+	ezSceneChanged(slot, 0);
+}
+
+void ezColour(EZobject* object, float r, float g, float b) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	g_ezCtx.objects.r[slot] = r;
+	g_ezCtx.objects.g[slot] = g;
+	g_ezCtx.objects.b[slot] = b;
+	ezSceneChanged(slot, 0);
+}
+
+void ezFilletRadius(EZobject* object, float radius) {
+	ezCornerRadii(object, radius, radius, radius, radius);
+}
+
+void ezCornerRadii(EZobject* object, float bottomLeft, float bottomRight, float topRight, float topLeft) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	float* radii = g_ezCtx.objects.radii[slot];
+	radii[0] = bottomLeft;
+	radii[1] = bottomRight;
+	radii[2] = topRight;
+	radii[3] = topLeft;
+	ezSceneChanged(slot, 1);
+}
+
+void ezBorder(EZobject* object, float width, float r, float g, float b) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	g_ezCtx.objects.borderWidth[slot] = width;
+
+	float* colour = g_ezCtx.objects.borderColour[slot];
+	colour[0] = r;
+	colour[1] = g;
+	colour[2] = b;
+	ezSceneChanged(slot, 1);
+}
+
+void ezTexture(EZobject* object, int image) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	g_ezCtx.objects.texture[slot] = image;
+	ezSceneChanged(slot, 1);
+}
+
+void ezDelete(EZobject* object) {
+	struct EzObjectPool* pool = &(g_ezCtx.objects);
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	ezSceneRemoveSlot(slot);
+
+	// invalidate existing handles
+	pool->generation[slot]++;
+
+	if ((pool->generation[slot] & EZ_HANDLE_GENERATION_MASK) == 0) {
+		pool->nextFree[slot] = EZ_SLOT_RETIRED;
+		return;
+	}
+
+	// put the slot on the end of the free list, so it's reused as late as possible
+	pool->nextFree[slot] = -1;
+
+	if (pool->freeTail >= 0) {
+		pool->nextFree[pool->freeTail] = slot;
+	} else {
+		pool->freeHead = slot;
+	}
+
+	pool->freeTail = slot;
+}
+
+// Image Functions
+
+// Creates an OpenGL texture object of the given size. Pixels may be NULL to leave it uninitialised.
+static unsigned int ezCreateTexture(const int width, const int height, const unsigned char* pixels) {
+	// generate opengl texture object
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	// bind texture
+	ezStateBindTexture(0, texture);
+
+	// only use NEAREST NEIGHBOUR!
+	// if you want your textures interpolated feel free to change this to GL_LINEAR / GL_LINEAR_MIPMAP_LINEAR tho
+	// could make interpolation method a parameter in a future version, or make another function to set it
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	// no need to unbind the texture: the state tracker knows it's bound
+	return texture;
+}
+
+static void ezDeleteTexture(const unsigned int texture) {
+	ezStateForgetTexture(texture);
+	glDeleteTextures(1, &texture);
+}
+
+// Creates the placeholder texture and works out the atlas page size
+static void ezInitImages(void) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	// placeholder until the real image arrives
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	table->whiteTexture = ezCreateTexture(1, 1, white);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	int maxSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	table->pageSize = maxSize < EZ_ATLAS_PAGE_SIZE ? maxSize : EZ_ATLAS_PAGE_SIZE;
+	table->atlasEnabled = 1;
+}
+
+// Deletes every image and atlas page
+static void ezFreeImages(void) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	for (int i = 0; i < table->capacity; i++) {
+		if (table->images[i].inUse && table->images[i].page < 0 && table->images[i].texture != table->whiteTexture) {
+			ezDeleteTexture(table->images[i].texture);
+		}
+
+		free(table->images[i].path);
+		free(table->images[i].pixels);
+	}
+
+	for (int i = 0; i < table->pageCount; i++) {
+		ezDeleteTexture(table->pages[i].texture);
+	}
+
+	ezDeleteTexture(table->whiteTexture);
+	free(table->images);
+	table->images = NULL;
+	table->capacity = 0;
+	table->pageCount = 0;
+}
+
+// Gets an image by id, or NULL if the id doesn't refer to a loaded image
+static struct EzImage* ezGetImage(const int image) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	if (image <= 0 || image > table->capacity || !table->images[image - 1].inUse) {
+		return NULL;
+	}
+
+	return &(table->images[image - 1]);
+}
+
+// Gets the OpenGL texture an image is drawn from, or 0 for no image
+static unsigned int ezImageTexture(const int image) {
+	const struct EzImage* entry = ezGetImage(image);
+	return entry ? entry->texture : 0;
+}
+
+// Reserves an image id, showing the white placeholder. Returns 0 if there's no memory for it.
+static int ezNewImage(void) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+	int index = 0;
+
+	// image loads are rare, so a linear search for a free entry is fine
+	while (index < table->capacity && table->images[index].inUse) {
+		index++;
+	}
+
+	if (index == table->capacity) {
+		const int capacity = table->capacity ? table->capacity * 2 : 16;
+		struct EzImage* images = realloc(table->images, sizeof(struct EzImage) * capacity);
+
+		if (images == NULL) {
+			fprintf(stderr, "Ran out of heap memory!\n");
+			return 0;
+		}
+
+		memset(images + table->capacity, 0, sizeof(struct EzImage) * (capacity - table->capacity));
+		table->images = images;
+		table->capacity = capacity;
+	}
+
+	struct EzImage* entry = &(table->images[index]);
+	memset(entry, 0, sizeof(struct EzImage));
+	entry->inUse = 1;
+	entry->texture = table->whiteTexture;
+	entry->page = -1;
+	entry->uvRect[2] = 1.0f;
+	entry->uvRect[3] = 1.0f;
+	entry->refCount = 1;
+	entry->lastUsed = ++table->tick;
+	entry->revision = ++table->revision;
+	return index + 1;
+}
+
+// Finds a loaded image with the given contents, or returns 0.
+// Matching on contents rather than path means the same file under two names is only loaded once,
+// and a file that has changed since it was loaded is loaded again.
+static int ezFindCachedImage(const unsigned long long hash, const long long fileSize) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	for (int i = 0; i < table->capacity; i++) {
+		const struct EzImage* entry = &(table->images[i]);
+
+		if (entry->inUse && !entry->loading && entry->bytes > 0 && entry->hash == hash && entry->fileSize == fileSize) {
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+// Finds a loaded image that came from the given file, or returns 0
+static int ezFindCachedPath(const char* fileName) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	for (int i = 0; i < table->capacity; i++) {
+		const struct EzImage* entry = &(table->images[i]);
+
+		if (entry->inUse && !entry->loading && entry->bytes > 0 && entry->path && strcmp(entry->path, fileName) == 0) {
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+// Takes another reference to a cached image
+static void ezReuseImage(const int image) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+	struct EzImage* entry = ezGetImage(image);
+
+	entry->refCount++;
+	entry->lastUsed = ++table->tick;
+	table->hits++;
+}
+
+// Empties an atlas page so all of its space can be handed out again
+static void ezResetAtlasPage(struct EzAtlasPage* page) {
+	page->nodeCount = 1;
+	page->nodeX[0] = 0;
+	page->nodeY[0] = 0;
+	page->nodeWidth[0] = g_ezCtx.images.pageSize;
+	page->images = 0;
+	page->usedPixels = 0;
+	page->paddingPixels = 0;
+	page->wastedPixels = 0;
+}
+
+// Finds the lowest spot on the skyline a region fits, leftmost on ties.
+// Returns the index of the segment the region starts on, or -1 if it doesn't fit.
+static int ezAtlasFindSpot(const struct EzAtlasPage* page, const int width, const int height, int* outY) {
+	const int size = g_ezCtx.images.pageSize;
+	int best = -1;
+	int bestY = size;
+
+	for (int i = 0; i < page->nodeCount; i++) {
+		if (page->nodeX[i] + width > size) {
+			break;
+		}
+
+		// the region sits on the highest segment beneath it
+		int y = 0;
+
+		for (int j = i, remaining = width; remaining > 0; j++) {
+			if (page->nodeY[j] > y) y = page->nodeY[j];
+			remaining -= page->nodeWidth[j];
+		}
+
+		if (y + height <= size && y < bestY) {
+			best = i;
+			bestY = y;
+		}
+	}
+
+	*outY = bestY;
+	return best;
+}
+
+// Raises the skyline over a region placed on segment 'node' at height y, and records the space wasted beneath it
+static void ezAtlasAddRegion(struct EzAtlasPage* page, const int node, const int y, const int width, const int height) {
+	const int x = page->nodeX[node];
+	const int right = x + width;
+
+	// gaps between the old skyline and the bottom of the region can never be used again
+	for (int j = node; j < page->nodeCount && page->nodeX[j] < right; j++) {
+		const int end = page->nodeX[j] + page->nodeWidth[j];
+		const int overlap = (end < right ? end : right) - page->nodeX[j];
+		page->wastedPixels += (long long)(y - page->nodeY[j]) * overlap;
+	}
+
+	// insert the new segment
+	memmove(page->nodeX + node + 1, page->nodeX + node, sizeof(int) * (page->nodeCount - node));
+	memmove(page->nodeY + node + 1, page->nodeY + node, sizeof(int) * (page->nodeCount - node));
+	memmove(page->nodeWidth + node + 1, page->nodeWidth + node, sizeof(int) * (page->nodeCount - node));
+	page->nodeX[node] = x;
+	page->nodeY[node] = y + height;
+	page->nodeWidth[node] = width;
+	page->nodeCount++;
+
+	// trim or remove the segments it covers
+	int next = node + 1;
+
+	while (next < page->nodeCount && page->nodeX[next] < right) {
+		const int shrink = right - page->nodeX[next];
+
+		if (shrink >= page->nodeWidth[next]) {
+			memmove(page->nodeX + next, page->nodeX + next + 1, sizeof(int) * (page->nodeCount - next - 1));
+			memmove(page->nodeY + next, page->nodeY + next + 1, sizeof(int) * (page->nodeCount - next - 1));
+			memmove(page->nodeWidth + next, page->nodeWidth + next + 1, sizeof(int) * (page->nodeCount - next - 1));
+			page->nodeCount--;
+		} else {
+			page->nodeX[next] += shrink;
+			page->nodeWidth[next] -= shrink;
+			break;
+		}
+	}
+
+	// merge neighbours at the same height
+	for (int i = 0; i + 1 < page->nodeCount; ) {
+		if (page->nodeY[i] == page->nodeY[i + 1]) {
+			page->nodeWidth[i] += page->nodeWidth[i + 1];
+			memmove(page->nodeX + i + 1, page->nodeX + i + 2, sizeof(int) * (page->nodeCount - i - 2));
+			memmove(page->nodeY + i + 1, page->nodeY + i + 2, sizeof(int) * (page->nodeCount - i - 2));
+			memmove(page->nodeWidth + i + 1, page->nodeWidth + i + 2, sizeof(int) * (page->nodeCount - i - 2));
+			page->nodeCount--;
+		} else {
+			i++;
+		}
+	}
+}
+
+// Creates a new atlas page. Returns its index, or -1 if there are already as many pages as allowed.
+static int ezNewAtlasPage(void) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	if (table->pageCount == EZ_ATLAS_MAX_PAGES) {
+		return -1;
+	}
+
+	struct EzAtlasPage* page = &(table->pages[table->pageCount]);
+	page->texture = ezCreateTexture(table->pageSize, table->pageSize, NULL);
+	// the gutters only protect this many mipmap levels
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, EZ_ATLAS_MIP_LEVELS);
+	ezResetAtlasPage(page);
+
+	return table->pageCount++;
+}
+
+// Packs an image into an atlas page. Returns 0 if there's no room (or no memory), in which case nothing changes.
+static int ezAtlasInsert(struct EzImage* entry, const unsigned char* pixels, const int width, const int height) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	// pad on every side, then round up to keep regions aligned
+	const int regionWidth = (width + 2 * EZ_ATLAS_PADDING + EZ_ATLAS_PADDING - 1) / EZ_ATLAS_PADDING * EZ_ATLAS_PADDING;
+	const int regionHeight = (height + 2 * EZ_ATLAS_PADDING + EZ_ATLAS_PADDING - 1) / EZ_ATLAS_PADDING * EZ_ATLAS_PADDING;
+
+	if (regionWidth > table->pageSize || regionHeight > table->pageSize) {
+		return 0;
+	}
+
+	// first page with room, or a new one
+	int pageIndex = -1;
+	int node = -1;
+	int y = 0;
+
+	for (int i = 0; i < table->pageCount && node < 0; i++) {
+		node = ezAtlasFindSpot(&(table->pages[i]), regionWidth, regionHeight, &y);
+		pageIndex = i;
+	}
+
+	if (node < 0) {
+		pageIndex = ezNewAtlasPage();
+
+		if (pageIndex < 0) {
+			return 0;
+		}
+
+		node = ezAtlasFindSpot(&(table->pages[pageIndex]), regionWidth, regionHeight, &y);
+	}
+
+	// copy the image into the middle of the region, stretching the edge pixels out into the gutter
+	unsigned char* region = malloc((size_t)regionWidth * regionHeight * 4);
+
+	if (region == NULL) {
+		return 0;
+	}
+
+	for (int row = 0; row < regionHeight; row++) {
+		int sourceRow = row - EZ_ATLAS_PADDING;
+		sourceRow = sourceRow < 0 ? 0 : (sourceRow >= height ? height - 1 : sourceRow);
+
+		for (int column = 0; column < regionWidth; column++) {
+			int sourceColumn = column - EZ_ATLAS_PADDING;
+			sourceColumn = sourceColumn < 0 ? 0 : (sourceColumn >= width ? width - 1 : sourceColumn);
+
+			memcpy(region + ((size_t)row * regionWidth + column) * 4, pixels + ((size_t)sourceRow * width + sourceColumn) * 4, 4);
+		}
+	}
+
+	struct EzAtlasPage* page = &(table->pages[pageIndex]);
+	const int x = page->nodeX[node];
+
+	ezStateBindTexture(0, page->texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, regionWidth, regionHeight, GL_RGBA, GL_UNSIGNED_BYTE, region);
+	free(region);
+
+	ezAtlasAddRegion(page, node, y, regionWidth, regionHeight);
+	page->images++;
+	page->usedPixels += (long long)width * height;
+	page->paddingPixels += (long long)regionWidth * regionHeight - (long long)width * height;
+	// regenerated before the page is next drawn, so loading many images only does it once
+	page->mipmapsDirty = 1;
+	table->mipmapsDirty = 1;
+
+	const float size = (float)table->pageSize;
+	entry->texture = page->texture;
+	entry->page = pageIndex;
+	entry->uvRect[0] = (x + EZ_ATLAS_PADDING) / size;
+	entry->uvRect[1] = (y + EZ_ATLAS_PADDING) / size;
+	entry->uvRect[2] = (x + EZ_ATLAS_PADDING + width) / size;
+	entry->uvRect[3] = (y + EZ_ATLAS_PADDING + height) / size;
+	entry->width = width;
+	entry->height = height;
+	entry->regionWidth = regionWidth;
+	entry->regionHeight = regionHeight;
+	return 1;
+}
+
+// Regenerates the mipmaps of atlas pages that have had images added
+static void ezUpdateAtlasMipmaps(void) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	if (!table->mipmapsDirty) {
+		return;
+	}
+
+	for (int i = 0; i < table->pageCount; i++) {
+		if (table->pages[i].mipmapsDirty) {
+			ezStateBindTexture(0, table->pages[i].texture);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			table->pages[i].mipmapsDirty = 0;
+		}
+	}
+
+	table->mipmapsDirty = 0;
+}
+
+// Sends decoded RGBA pixels to the GPU for an image: into an atlas page if it's small enough, otherwise its own texture
+static void ezPlaceImage(const int image, const unsigned char* pixels, const int width, const int height) {
+	struct EzImage* entry = ezGetImage(image);
+
+	ezTraceBegin("upload image");
+
+	if (g_ezCtx.images.atlasEnabled && width <= EZ_ATLAS_MAX_IMAGE_SIZE && height <= EZ_ATLAS_MAX_IMAGE_SIZE
+			&& ezAtlasInsert(entry, pixels, width, height)) {
+		entry->bytes = (long long)entry->regionWidth * entry->regionHeight * 4;
+	} else {
+		entry->texture = ezCreateTexture(width, height, pixels);
+		entry->width = width;
+		entry->height = height;
+		glGenerateMipmap(GL_TEXTURE_2D);
+		// the mipmap chain adds about a third
+		entry->bytes = (long long)width * height * 4 * 4 / 3;
+	}
+
+	g_ezCtx.images.residentBytes += entry->bytes;
+	entry->revision = ++g_ezCtx.images.revision;
+
+	// without its copy, the software renderer draws the image as plain white.
+	// It gets as many mipmaps as the texture it's in, so both renderers pick the same ones.
+	if (g_ezCtx.images.keepPixels) {
+		entry->pixels = ezSoftwareMipmaps(pixels, width, height, entry->page >= 0 ? EZ_ATLAS_MIP_LEVELS : 32, &(entry->pixelLevels));
+	}
+
+	ezTraceEnd();
+}
+
+// Reads a whole file into memory. Returns NULL if the file cannot be read.
+static unsigned char* ezReadFile(const char* fileName, long long* size) {
+	FILE* file = fopen(fileName, "rb");
+
+	if (file == NULL) {
+		return NULL;
+	}
+
+	unsigned char* data = NULL;
+
+	if (fseek(file, 0, SEEK_END) == 0) {
+		const long length = ftell(file);
+
+		if (length > 0 && fseek(file, 0, SEEK_SET) == 0 && (data = malloc(length)) != NULL) {
+			if (fread(data, 1, length, file) == (size_t)length) {
+				*size = length;
+			} else {
+				free(data);
+				data = NULL;
+			}
+		}
+	}
+
+	fclose(file);
+	return data;
+}
+
+// 64 bit FNV-1a hash of a block of memory
+static unsigned long long ezHash(const unsigned char* data, const long long size) {
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (long long i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+// Decodes an image file already in memory to RGBA pixels, flipped so the first row is the bottom of the image.
+// Safe to call from any thread. Returns NULL if the file isn't a valid image.
+static unsigned char* ezDecodeImage(const unsigned char* file, const long long fileSize, int* width, int* height) {
+	int channels;
+	// always ask for 4 channels so every image can be uploaded the same way
+	return stbi_load_from_memory(file, (int)fileSize, width, height, &channels, STBI_rgb_alpha);
+}
+
+// Frees an image's GPU memory and its id
+static void ezReleaseImage(const int image) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+	struct EzImage* entry = ezGetImage(image);
+
+	if (entry->page >= 0) {
+		// the skyline can't take back a single region, so its space stays wasted until the page is empty
+		struct EzAtlasPage* page = &(table->pages[entry->page]);
+		const long long area = (long long)entry->regionWidth * entry->regionHeight;
+		const long long imageArea = (long long)entry->width * entry->height;
+
+		page->usedPixels -= imageArea;
+		page->paddingPixels -= area - imageArea;
+		page->wastedPixels += area;
+
+		if (--page->images == 0) {
+			ezResetAtlasPage(page);
+		}
+	} else if (entry->texture != table->whiteTexture) {
+		ezDeleteTexture(entry->texture);
+	}
+
+	table->residentBytes -= entry->bytes;
+	free(entry->path);
+	free(entry->pixels);
+	entry->path = NULL;
+	entry->pixels = NULL;
+	entry->inUse = 0;
+	entry->revision = ++table->revision;
+}
+
+// Frees the least recently used unreferenced images until the cache fits in its memory budget.
+// Images still referenced are never evicted, so the budget can be exceeded by them alone.
+static void ezEvictImages(void) {
+	struct EzImageTable* table = &(g_ezCtx.images);
+
+	while (table->residentBytes > table->memoryBudget) {
+		int oldest = 0;
+
+		for (int i = 0; i < table->capacity; i++) {
+			const struct EzImage* entry = &(table->images[i]);
+
+			if (entry->inUse && entry->refCount == 0 && (oldest == 0 || entry->lastUsed < table->images[oldest - 1].lastUsed)) {
+				oldest = i + 1;
+			}
+		}
+
+		if (oldest == 0) {
+			return;
+		}
+
+		ezReleaseImage(oldest);
+		table->evictions++;
+	}
+}
+
+// Records where an image came from so later loads of the same file can reuse it
+static void ezSetImageSource(const int image, const char* fileName, const unsigned long long hash, const long long fileSize) {
+	struct EzImage* entry = ezGetImage(image);
+	const size_t length = strlen(fileName);
+
+	entry->hash = hash;
+	entry->fileSize = fileSize;
+	entry->path = malloc(length + 1);
+
+	// the path only speeds up ezLoadImageAsync, so it's fine to go without
+	if (entry->path) {
+		memcpy(entry->path, fileName, length + 1);
+	}
+}
+
+int ezLoadImage(const char* fileName) {
+	ezTraceBegin("ezLoadImage");
+
+	// ===========
+	// STEP 1: check whether the image is already loaded
+	// ============
+	long long fileSize = 0;
+	unsigned char* file = ezReadFile(fileName, &fileSize);
+	const unsigned long long hash = file ? ezHash(file, fileSize) : 0;
+	int image = file ? ezFindCachedImage(hash, fileSize) : 0;
+
+	if (image) {
+		ezReuseImage(image);
+		free(file);
+		ezTraceEnd();
+		return image;
+	}
+
+	g_ezCtx.images.misses++;
+
+	// ===========
+	// STEP 2: reserve an image id
+	// ============
+	image = ezNewImage();
+
+	if (image == 0) {
+		free(file);
+		ezTraceEnd();
+		return 0;
+	}
+
+	// ===========
+	// STEP 3: actually load image
+	// ============
+	int width, height;
+	ezTraceBegin("decode image");
+	unsigned char* data = file ? ezDecodeImage(file, fileSize, &width, &height) : NULL;
+	ezTraceEnd();
+
+	if (data == NULL) {
+		fprintf(stderr, "Failed to load image %s\n", fileName);
+		free(file);
+		ezTraceEnd();
+		return image;
+	}
+
+	// load image data to the gpu
+	ezPlaceImage(image, data, width, height);
+	ezSetImageSource(image, fileName, hash, fileSize);
+
+	// free loaded image data
+	stbi_image_free(data);
+	free(file);
+	ezEvictImages();
+	ezTraceEnd();
+	return image;
+}
+
+// Takes the first job off a job list. Must hold the loader mutex.
+static struct EzImageJob* ezPopImageJob(struct EzImageJob** head, struct EzImageJob** tail) {
+	struct EzImageJob* job = *head;
+
+	if (job) {
+		*head = job->next;
+
+		if (*head == NULL) {
+			*tail = NULL;
+		}
+
+		job->next = NULL;
+	}
+
+	return job;
+}
+
+// Adds a job to the end of a job list. Must hold the loader mutex.
+static void ezPushImageJob(struct EzImageJob** head, struct EzImageJob** tail, struct EzImageJob* job) {
+	job->next = NULL;
+
+	if (*tail) {
+		(*tail)->next = job;
+	} else {
+		*head = job;
+	}
+
+	*tail = job;
+}
+
+static void ezFreeImageJob(struct EzImageJob* job) {
+	stbi_image_free(job->pixels);
+	free(job->fileName);
+	free(job);
+}
+
+// Worker thread: decodes queued images until told to stop
+static EZ_THREAD_PROC(ezImageWorker) {
+	struct EzImageLoader* loader = arg;
+
+	t_ezThreadName = "image loader";
+	ezMutexLock(&(loader->mutex));
+
+	for (;;) {
+		while (loader->pending == NULL && !loader->shutdown) {
+			ezCondWait(&(loader->wake), &(loader->mutex));
+		}
+
+		if (loader->shutdown) {
+			break;
+		}
+
+		struct EzImageJob* job = ezPopImageJob(&(loader->pending), &(loader->pendingTail));
+		job->next = loader->active;
+		loader->active = job;
+
+		// decode without holding the lock so the other workers can carry on
+		ezMutexUnlock(&(loader->mutex));
+		ezTraceBegin("decode image");
+		unsigned char* file = ezReadFile(job->fileName, &(job->fileSize));
+
+		if (file) {
+			job->hash = ezHash(file, job->fileSize);
+			job->pixels = ezDecodeImage(file, job->fileSize, &(job->width), &(job->height));
+			free(file);
+		}
+
+		ezTraceEnd();
+		ezMutexLock(&(loader->mutex));
+
+		struct EzImageJob** link = &(loader->active);
+
+		while (*link != job) {
+			link = &((*link)->next);
+		}
+
+		*link = job->next;
+		ezPushImageJob(&(loader->ready), &(loader->readyTail), job);
+		loader->decoding--;
+		ezCondBroadcast(&(loader->decoded));
+	}
+
+	ezMutexUnlock(&(loader->mutex));
+	EZ_THREAD_RETURN;
+}
+
+// Starts the worker threads. Returns the number of workers running.
+static int ezStartImageLoader(void) {
+	struct EzImageLoader* loader = &(g_ezCtx.imageLoader);
+
+	ezMutexInit(&(loader->mutex));
+	ezCondInit(&(loader->wake));
+	ezCondInit(&(loader->decoded));
+
+	// leave a processor for the render thread
+	int workers = ezProcessorCount() - 1;
+
+	if (workers < 1) {
+		workers = 1;
+	} else if (workers > EZ_MAX_IMAGE_WORKERS) {
+		workers = EZ_MAX_IMAGE_WORKERS;
+	}
+
+	while (loader->workerCount < workers && ezThreadStart(&(loader->workers[loader->workerCount]), ezImageWorker, loader)) {
+		loader->workerCount++;
+	}
+
+	if (loader->workerCount == 0) {
+		ezCondDestroy(&(loader->decoded));
+		ezCondDestroy(&(loader->wake));
+		ezMutexDestroy(&(loader->mutex));
+	}
+
+	return loader->workerCount;
+}
+
+// Stops the worker threads and discards any images that haven't finished loading
+static void ezStopImageLoader(void) {
+	struct EzImageLoader* loader = &(g_ezCtx.imageLoader);
+
+	if (loader->workerCount == 0) {
+		return;
+	}
+
+	ezMutexLock(&(loader->mutex));
+	loader->shutdown = 1;
+	ezCondBroadcast(&(loader->wake));
+	ezMutexUnlock(&(loader->mutex));
+
+	for (int i = 0; i < loader->workerCount; i++) {
+		ezThreadJoin(loader->workers[i]);
+	}
+
+	struct EzImageJob* job;
+
+	while ((job = ezPopImageJob(&(loader->pending), &(loader->pendingTail))) != NULL) {
+		ezFreeImageJob(job);
+	}
+
+	while ((job = ezPopImageJob(&(loader->ready), &(loader->readyTail))) != NULL) {
+		ezFreeImageJob(job);
+	}
+
+	ezCondDestroy(&(loader->decoded));
+	ezCondDestroy(&(loader->wake));
+	ezMutexDestroy(&(loader->mutex));
+	loader->workerCount = 0;
+}
+
+// Sends a decoded job to the GPU, runs its function, and frees it. Render thread only.
+// The job must already be off the loader's lists, so nothing else can cancel it.
+static void ezFinishImageJob(struct EzImageJob* job) {
+	// skip images freed while they were loading. Their slot may since have gone to another image.
+	struct EzImage* entry = job->cancelled ? NULL : ezGetImage(job->image);
+
+	if (entry) {
+		entry->loading = 0;
+
+		if (job->pixels) {
+			ezPlaceImage(job->image, job->pixels, job->width, job->height);
+			ezSetImageSource(job->image, job->fileName, job->hash, job->fileSize);
+			ezEvictImages();
+		} else {
+			fprintf(stderr, "Failed to load image %s\n", job->fileName);
+		}
+
+		if (job->onLoaded) {
+			job->onLoaded(job->image, job->pixels != NULL);
+		}
+	}
+
+	ezFreeImageJob(job);
+}
+
+// Uploads background-loaded images until the time budget for this frame runs out
+static void ezUploadLoadedImages(void) {
+	struct EzImageLoader* loader = &(g_ezCtx.imageLoader);
+
+	if (loader->workerCount == 0) {
+		return;
+	}
+
+	const double start = ezTime();
+
+	do {
+		ezMutexLock(&(loader->mutex));
+		struct EzImageJob* job = ezPopImageJob(&(loader->ready), &(loader->readyTail));
+		ezMutexUnlock(&(loader->mutex));
+
+		if (job == NULL) {
+			break;
+		}
+
+		ezFinishImageJob(job);
+	} while (ezTime() - start < loader->uploadBudget);
+}
+
+int ezLoadImageAsync(const char* fileName, EZimagefun function) {
+	struct EzImageLoader* loader = &(g_ezCtx.imageLoader);
+
+	// the file isn't read here, so only a load of the same path can be reused
+	const int cached = ezFindCachedPath(fileName);
+
+	if (cached) {
+		ezReuseImage(cached);
+
+		if (function) {
+			function(cached, 1);
+		}
+
+		return cached;
+	}
+
+	// fall back to loading right now if there are no threads to load on
+	if (loader->workerCount == 0 && ezStartImageLoader() == 0) {
+		const int image = ezLoadImage(fileName);
+		// images that fail to load keep their id, drawn with the placeholder and holding no GPU memory
+		const struct EzImage* entry = ezGetImage(image);
+
+		if (function) {
+			function(image, entry != NULL && entry->bytes > 0);
+		}
+
+		return image;
+	}
+
+	struct EzImageJob* job = calloc(1, sizeof(struct EzImageJob));
+	const size_t length = strlen(fileName);
+	char* fileNameCopy = malloc(length + 1);
+	// shows the placeholder until it's loaded
+	const int image = job && fileNameCopy ? ezNewImage() : 0;
+
+	if (image == 0) {
+		free(job);
+		free(fileNameCopy);
+		fprintf(stderr, "Ran out of heap memory!\n");
+		return 0;
+	}
+
+	memcpy(fileNameCopy, fileName, length + 1);
+	job->fileName = fileNameCopy;
+	job->onLoaded = function;
+	job->image = image;
+	ezGetImage(image)->loading = 1;
+	g_ezCtx.images.misses++;
+
+	ezMutexLock(&(loader->mutex));
+	ezPushImageJob(&(loader->pending), &(loader->pendingTail), job);
+	loader->decoding++;
+	ezCondSignal(&(loader->wake));
+	ezMutexUnlock(&(loader->mutex));
+
+	return image;
+}
+
+void ezWaitForImages(void) {
+	struct EzImageLoader* loader = &(g_ezCtx.imageLoader);
+
+	if (loader->workerCount == 0) {
+		return;
+	}
+
+	for (;;) {
+		ezMutexLock(&(loader->mutex));
+
+		while (loader->ready == NULL && loader->decoding > 0) {
+			ezCondWait(&(loader->decoded), &(loader->mutex));
+		}
+
+		struct EzImageJob* job = ezPopImageJob(&(loader->ready), &(loader->readyTail));
+		ezMutexUnlock(&(loader->mutex));
+
+		// nothing ready and nothing left decoding
+		if (job == NULL) {
+			return;
+		}
+
+		ezFinishImageJob(job);
+	}
+}
+
+void ezSetImageUploadBudget(double milliseconds) {
+	g_ezCtx.imageLoader.uploadBudget = milliseconds / 1000.0;
+}
+
+void ezSetAtlasEnabled(int enabled) {
+	g_ezCtx.images.atlasEnabled = enabled;
+}
+
+void ezGetAtlasStats(EZatlasstats* stats) {
+	const struct EzImageTable* table = &(g_ezCtx.images);
+	memset(stats, 0, sizeof(EZatlasstats));
+
+	for (int i = 0; i < table->pageCount; i++) {
+		const struct EzAtlasPage* page = &(table->pages[i]);
+
+		if (page->images == 0) {
+			continue;
+		}
+
+		stats->pages++;
+		stats->images += page->images;
+		stats->usedPixels += page->usedPixels;
+		stats->paddingPixels += page->paddingPixels;
+		stats->wastedPixels += page->wastedPixels;
+	}
+
+	if (stats->pages > 0) {
+		stats->fillRatio = (double)stats->usedPixels / ((double)stats->pages * table->pageSize * table->pageSize);
+	}
+}
+
+void ezFreeImage(int image) {
+	struct EzImageLoader* loader = &(g_ezCtx.imageLoader);
+	struct EzImage* entry = ezGetImage(image);
+
+	if (entry == NULL || entry->refCount == 0) {
+		return;
+	}
+
+	// other loads of the same image still use it
+	if (--entry->refCount > 0) {
+		return;
+	}
+
+	// keep it around in case it's loaded again, as long as there's room in the budget
+	if (!entry->loading && entry->bytes > 0 && g_ezCtx.images.memoryBudget > 0) {
+		entry->lastUsed = ++g_ezCtx.images.tick;
+		ezEvictImages();
+		return;
+	}
+
+	// cancel the upload if it's still loading, whether it's waiting, being decoded or waiting to be uploaded
+	if (entry->loading && loader->workerCount > 0) {
+		ezMutexLock(&(loader->mutex));
+		struct EzImageJob* const lists[3] = { loader->pending, loader->active, loader->ready };
+
+		for (int i = 0; i < 3; i++) {
+			for (struct EzImageJob* job = lists[i]; job; job = job->next) {
+				if (job->image == image) job->cancelled = 1;
+			}
+		}
+
+		ezMutexUnlock(&(loader->mutex));
+	}
+
+	ezReleaseImage(image);
+}
+
+void ezSetImageMemoryBudget(long long bytes) {
+	g_ezCtx.images.memoryBudget = bytes > 0 ? bytes : 0;
+	ezEvictImages();
+}
+
+void ezGetImageCacheStats(EZimagecachestats* stats) {
+	const struct EzImageTable* table = &(g_ezCtx.images);
+	memset(stats, 0, sizeof(EZimagecachestats));
+
+	stats->hits = table->hits;
+	stats->misses = table->misses;
+	stats->evictions = table->evictions;
+	stats->residentBytes = table->residentBytes;
+
+	for (int i = 0; i < table->capacity; i++) {
+		if (table->images[i].inUse && table->images[i].refCount == 0) {
+			stats->unreferencedImages++;
+		} else if (table->images[i].inUse) {
+			stats->images++;
+		}
+	}
+}
+
+// Camera
+// The camera is applied in the vertex shader, so moving it costs the same however many objects there are.
+// Instance positions are sent relative to a point near the camera rather than to 0, so a float is enough for them
+// however far out in the world the camera is.
+
+// Maps a point in the world to the window, through a camera
+static void ezCameraToScreen(const struct EzCamera* camera, const double x, const double y, double screen[2]) {
+	const double centreX = g_ezCtx.winWidth * 0.5;
+	const double centreY = g_ezCtx.winHeight * 0.5;
+	const double sine = camera->sine * camera->zoom;
+	const double cosine = camera->cosine * camera->zoom;
+	const double dx = x - camera->x - centreX;
+	const double dy = y - camera->y - centreY;
+
+	screen[0] = centreX + dx * cosine - dy * sine;
+	screen[1] = centreY + dx * sine + dy * cosine;
+}
+
+// Maps a point in the window to the world, through a camera
+static void ezCameraToWorld(const struct EzCamera* camera, const double x, const double y, double world[2]) {
+	const double centreX = g_ezCtx.winWidth * 0.5;
+	const double centreY = g_ezCtx.winHeight * 0.5;
+	const double sine = camera->sine / camera->zoom;
+	const double cosine = camera->cosine / camera->zoom;
+	const double dx = x - centreX;
+	const double dy = y - centreY;
+
+	world[0] = camera->x + centreX + dx * cosine + dy * sine;
+	world[1] = camera->y + centreY - dx * sine + dy * cosine;
+}
+
+// Applies a change to the camera. Anything already batched is drawn first, through the camera it was drawn with.
+static void ezSetCamera(const struct EzCamera* camera) {
+	struct EzBatch* batch = &(g_ezCtx.batch);
+
+	if (batch->count > 0) {
+		ezFlushBatch();
+		g_ezCtx.stats.flushes++;
+	}
+
+	g_ezCtx.camera = *camera;
+	g_ezCtx.camera.viewWidth = -1;
+	batch->origin[0] = camera->x;
+	batch->origin[1] = camera->y;
+}
+
+void ezCameraMove(double x, double y) {
+	struct EzCamera camera = g_ezCtx.camera;
+	camera.x = x;
+	camera.y = y;
+	ezSetCamera(&camera);
+}
+
+void ezCameraZoom(float zoom) {
+	if (!(zoom > 0.0f)) {
+		fprintf(stderr, "Camera zoom must be above 0!\n");
+		return;
+	}
+
+	struct EzCamera camera = g_ezCtx.camera;
+	camera.zoom = zoom;
+	ezSetCamera(&camera);
+}
+
+void ezCameraRotate(float radians) {
+	struct EzCamera camera = g_ezCtx.camera;
+	camera.rotation = radians;
+	camera.sine = sin(radians);
+	camera.cosine = cos(radians);
+	ezSetCamera(&camera);
+}
+
+void ezScreenToWorld(double x, double y, double* worldX, double* worldY) {
+	double world[2];
+	ezCameraToWorld(&(g_ezCtx.camera), x, y, world);
+	*worldX = world[0];
+	*worldY = world[1];
+}
+
+// Draw Functions
+
+// Defined with the rest of the picking code
+static void ezPickRecord(const int slot);
+
+void ezBackgroundColour(float r, float g, float b) {
+	glClearColor(r, g, b, 1.0f);
+	g_ezCtx.clearColour[0] = r;
+	g_ezCtx.clearColour[1] = g;
+	g_ezCtx.clearColour[2] = b;
+}
+
+// Whether an object has rounded corners or a border, which are drawn with blended edges
+static int ezSoftEdged(const int slot) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+	const float* radii = pool->radii[slot];
+	return radii[0] > 0.0f || radii[1] > 0.0f || radii[2] > 0.0f || radii[3] > 0.0f || pool->borderWidth[slot] > 0.0f;
+}
+
+// Gets a rectangle in the world an object is inside: left, bottom, right, top.
+// This is exactly the area it fills, unless it's turned.
+static void ezObjectRect(const int slot, double rect[4]) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+	const double x = pool->x[slot];
+	const double y = pool->y[slot];
+
+	// its edges relative to the anchor point, as stretched
+	const double width = (double)pool->width[slot] * pool->scaleX[slot];
+	const double height = (double)pool->height[slot] * pool->scaleY[slot];
+	const double left = -pool->anchorX[slot] * width;
+	const double bottom = -pool->anchorY[slot] * height;
+	const double right = left + width;
+	const double top = bottom + height;
+
+	// however it's turned, it stays within reach of its furthest corner. That's cheaper than turning each corner.
+	if (pool->rotation[slot] != 0.0f) {
+		const double reachX = fabs(left) > fabs(right) ? fabs(left) : fabs(right);
+		const double reachY = fabs(bottom) > fabs(top) ? fabs(bottom) : fabs(top);
+		const double reach = sqrt(reachX * reachX + reachY * reachY);
+
+		rect[0] = x - reach;
+		rect[1] = y - reach;
+		rect[2] = x + reach;
+		rect[3] = y + reach;
+		return;
+	}
+
+	rect[0] = x + (left < right ? left : right);
+	rect[1] = y + (bottom < top ? bottom : top);
+	rect[2] = x + (left < right ? right : left);
+	rect[3] = y + (bottom < top ? top : bottom);
+}
+
+// Gets the area of the world the camera can see: left, bottom, right, top.
+// Includes a pixel around the window, which the soft edges of objects just outside it blend into.
+static void ezViewBounds(double bounds[4]) {
+	struct EzCamera* camera = &(g_ezCtx.camera);
+
+	// every object drawn is checked against this, so it's only worked out again when the camera or window changes
+	if (camera->viewWidth != g_ezCtx.winWidth || camera->viewHeight != g_ezCtx.winHeight) {
+		const double width = g_ezCtx.winWidth;
+		const double height = g_ezCtx.winHeight;
+		const double corners[4][2] = { { 0.0, 0.0 }, { width, 0.0 }, { width, height }, { 0.0, height } };
+		const double pixel = 1.0 / camera->zoom;
+		double* view = camera->view;
+
+		for (int i = 0; i < 4; i++) {
+			double world[2];
+			ezCameraToWorld(camera, corners[i][0], corners[i][1], world);
+
+			if (i == 0 || world[0] < view[0]) view[0] = world[0];
+			if (i == 0 || world[1] < view[1]) view[1] = world[1];
+			if (i == 0 || world[0] > view[2]) view[2] = world[0];
+			if (i == 0 || world[1] > view[3]) view[3] = world[1];
+		}
+
+		view[0] -= pixel;
+		view[1] -= pixel;
+		view[2] += pixel;
+		view[3] += pixel;
+		camera->viewWidth = g_ezCtx.winWidth;
+		camera->viewHeight = g_ezCtx.winHeight;
+	}
+
+	memcpy(bounds, camera->view, sizeof(camera->view));
+}
+
+// Whether an object overlaps an area of the world, given as left, bottom, right, top
+static int ezObjectOverlaps(const int slot, const double area[4]) {
+	double rect[4];
+	ezObjectRect(slot, rect);
+	return rect[0] < area[2] && rect[2] > area[0] && rect[1] < area[3] && rect[3] > area[1];
+}
+
+// Whether an object should be drawn, counting it as culled if not
+static int ezObjectVisible(const int slot) {
+	if (!g_ezCtx.culling) {
+		return 1;
+	}
+
+	double view[4];
+	ezViewBounds(view);
+
+	if (ezObjectOverlaps(slot, view)) {
+		return 1;
+	}
+
+	g_ezCtx.stats.culled++;
+	return 0;
+}
+
+// Writes the instance data the shaders draw an object with. The image is the object's texture, if it has one.
+// The position is written relative to the origin, a point in the world near the camera.
+static void ezWriteInstance(float* instance, const int slot, const struct EzImage* image, const float depth, const double origin[2]) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+
+	instance[0] = (float)(pool->x[slot] - origin[0]);
+	instance[1] = (float)(pool->y[slot] - origin[1]);
+	instance[2] = pool->width[slot];
+	instance[3] = pool->height[slot];
+	instance[4] = pool->anchorX[slot];
+	instance[5] = pool->anchorY[slot];
+	instance[6] = pool->r[slot];
+	instance[7] = pool->g[slot];
+	instance[8] = pool->b[slot];
+	instance[9] = pool->borderWidth[slot];
+	// 0 is treated as false, all else is true
+	instance[10] = image && image->texture ? 1.0f : 0.0f;
+	instance[11] = depth;
+
+	// where in the texture the image is, for images in atlas pages
+	if (image) {
+		memcpy(instance + 12, image->uvRect, sizeof(float) * 4);
+	} else {
+		instance[12] = 0.0f;
+		instance[13] = 0.0f;
+		instance[14] = 1.0f;
+		instance[15] = 1.0f;
+	}
+
+	memcpy(instance + 16, pool->radii[slot], sizeof(float) * 4);
+	memcpy(instance + 20, pool->borderColour[slot], sizeof(float) * 3);
+
+	// turned and stretched in the vertex shader, so there's nothing to work out here
+	instance[23] = pool->rotation[slot];
+	instance[24] = pool->scaleX[slot];
+	instance[25] = pool->scaleY[slot];
+	instance[26] = 0.0f;
+	instance[27] = 0.0f;
+}
+
+static void ezBatchObject(const int slot) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+	struct EzBatch* batch = &(g_ezCtx.batch);
+	const struct EzImage* image = ezGetImage(pool->texture[slot]);
+	const unsigned int texture = image ? image->texture : 0;
+
+	// a batch can only use one texture
+	const int textureClash = texture && batch->texture && texture != batch->texture;
+
+	if (batch->count > 0 && (textureClash || batch->count == EZ_BATCH_CAPACITY)) {
+		ezFlushBatch();
+		g_ezCtx.stats.flushes++;
+	}
+
+	if (texture) {
+		batch->texture = texture;
+		batch->variant |= EZ_VARIANT_TEXTURED;
+	}
+
+	if (ezSoftEdged(slot)) {
+		batch->variant |= EZ_VARIANT_FILLETED;
+	}
+
+	if (batch->count == 0) {
+		ezReserveInstances();
+	}
+
+	ezWriteInstance(batch->instances + EZ_INSTANCE_SIZE * batch->count, slot, image, batch->depth, batch->origin);
+	batch->count++;
+	g_ezCtx.stats.objects++;
+}
+
+// Queues an object for the software rasterizer
+static void ezRasterizeObject(const int slot) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+	const struct EzImage* image = ezGetImage(pool->texture[slot]);
+	const struct EzCamera* camera = &(g_ezCtx.camera);
+	const float rotation = pool->rotation[slot];
+	const float scaleX = pool->scaleX[slot];
+	const float scaleY = pool->scaleY[slot];
+	struct EzSoftwareShape shape;
+
+	// upright shapes stretched the same both ways are just sized in window coordinates, which the rasterizer draws fastest.
+	// Anything else is left in the object's own units, with the camera and the object's own transform together mapping it to the window.
+	const int upright = camera->rotation == 0.0f && rotation == 0.0f && scaleX == scaleY && scaleX > 0.0f;
+	const float size = upright ? camera->zoom * scaleX : 1.0f;
+
+	// the bottom left corner, turned and stretched about the anchor point
+	const double cornerX = -pool->anchorX[slot] * pool->width[slot] * scaleX;
+	const double cornerY = -pool->anchorY[slot] * pool->height[slot] * scaleY;
+	const double sine = rotation == 0.0f ? 0.0 : sin(rotation);
+	const double cosine = rotation == 0.0f ? 1.0 : cos(rotation);
+	double corner[2];
+	ezCameraToScreen(camera, pool->x[slot] + cornerX * cosine - cornerY * sine, pool->y[slot] + cornerX * sine + cornerY * cosine, corner);
+
+	shape.x = (float)corner[0];
+	shape.y = (float)corner[1];
+	shape.width = pool->width[slot] * size;
+	shape.height = pool->height[slot] * size;
+	shape.r = pool->r[slot];
+	shape.g = pool->g[slot];
+	shape.b = pool->b[slot];
+
+	for (int i = 0; i < 4; i++) {
+		shape.radii[i] = pool->radii[slot][i] * size;
+	}
+
+	if (upright) {
+		shape.transform[0] = 1.0f;
+		shape.transform[1] = 0.0f;
+		shape.transform[2] = 0.0f;
+		shape.transform[3] = 1.0f;
+	} else {
+		const double angle = (double)camera->rotation + rotation;
+		const double turnSine = sin(angle) * camera->zoom;
+		const double turnCosine = cos(angle) * camera->zoom;
+
+		shape.transform[0] = (float)(turnCosine * scaleX);
+		shape.transform[1] = (float)(turnSine * scaleX);
+		shape.transform[2] = (float)(-turnSine * scaleY);
+		shape.transform[3] = (float)(turnCosine * scaleY);
+	}
+
+	shape.borderWidth = pool->borderWidth[slot] * size;
+	shape.borderR = pool->borderColour[slot][0];
+	shape.borderG = pool->borderColour[slot][1];
+	shape.borderB = pool->borderColour[slot][2];
+	shape.texels = image ? image->pixels : NULL;
+	shape.textureWidth = image ? image->width : 0;
+	shape.textureHeight = image ? image->height : 0;
+	shape.textureLevels = image ? image->pixelLevels : 0;
+
+	ezSoftwareAdd(&shape);
+	g_ezCtx.stats.objects++;
+}
+
+// Draws the object in a pool slot, if it's on screen. Returns whether it was drawn.
+static int ezDrawSlot(const int slot) {
+	if (!ezObjectVisible(slot)) return 0;
+
+	if (g_ezCtx.software.active) {
+		ezRasterizeObject(slot);
+	} else {
+		ezBatchObject(slot);
+	}
+
+	return 1;
+}
+
+void ezDraw(EZobject *object) {
+	const int slot = ezObjectSlot(object);
+
+	if (slot >= 0 && ezDrawSlot(slot)) {
+		ezPickRecord(slot);
+	}
+}
+
+// Orders by texture, keeping the original order between objects with the same texture
+static int ezCompareSortEntries(const void* a, const void* b) {
+	const struct EzSortEntry* entryA = a;
+	const struct EzSortEntry* entryB = b;
+
+	if (entryA->texture != entryB->texture) {
+		return entryA->texture < entryB->texture ? -1 : 1;
+	}
+
+	return entryA->index - entryB->index;
+}
+
+// Orders by position in the original array
+static int ezCompareSortIndices(const void* a, const void* b) {
+	return ((const struct EzSortEntry*)a)->index - ((const struct EzSortEntry*)b)->index;
+}
+
+// Draws up to EZ_DRAW_MANY_CHUNK objects grouped by texture.
+// Each object gets a depth nearer than everything drawn before it this frame, so with the depth test on,
+// later objects still end up in front of earlier ones no matter which batch they are drawn in.
+static void ezDrawManySorted(EZobject** objects, int count) {
+	struct EzSortEntry* entries = g_ezCtx.sortEntries;
+	// untextured objects fit in any batch, so only count the textured ones
+	int runs = 0;
+	unsigned int texture = 0;
+	// blended edges take on whatever is under them, so objects with them have to be drawn in order
+	int softEdged = 0;
+
+	for (int i = 0; i < count; i++) {
+		entries[i].slot = ezObjectSlot(objects[i]);
+		if (entries[i].slot >= 0 && !ezObjectVisible(entries[i].slot)) entries[i].slot = -1;
+		if (entries[i].slot >= 0) ezPickRecord(entries[i].slot);
+		if (entries[i].slot >= 0 && ezSoftEdged(entries[i].slot)) softEdged = 1;
+		entries[i].texture = entries[i].slot < 0 ? 0 : ezImageTexture(g_ezCtx.objects.texture[entries[i].slot]);
+		entries[i].index = i;
+
+		if (entries[i].texture && entries[i].texture != texture) {
+			texture = entries[i].texture;
+			runs++;
+		}
+	}
+
+	qsort(entries, count, sizeof(struct EzSortEntry), ezCompareSortEntries);
+
+	int groups = 0;
+	texture = 0;
+
+	for (int i = 0; i < count; i++) {
+		if (entries[i].texture && entries[i].texture != texture) {
+			texture = entries[i].texture;
+			groups++;
+		}
+	}
+
+	// already grouped by texture: drawing in order takes just as few batches.
+	// Also drawn in order if anything is soft edged, or the frame is out of depths to give them.
+	if (runs <= groups || softEdged || g_ezCtx.batch.depthLevels + count > EZ_DEPTH_LEVELS) {
+		qsort(entries, count, sizeof(struct EzSortEntry), ezCompareSortIndices);
+
+		for (int i = 0; i < count; i++) {
+			if (entries[i].slot >= 0) ezBatchObject(entries[i].slot);
+		}
+
+		return;
+	}
+
+	// anything already queued must be drawn underneath
+	ezFlushBatch();
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	const int levels = g_ezCtx.batch.depthLevels;
+
+	for (int i = 0; i < count; i++) {
+		if (entries[i].slot < 0) continue;
+
+		// step from the cleared depth of 1 towards -1, one level per object, nearest last
+		g_ezCtx.batch.depth = 1.0f - 2.0f * (float)(levels + entries[i].index + 1) / (float)EZ_DEPTH_LEVELS;
+		ezBatchObject(entries[i].slot);
+	}
+
+	ezFlushBatch();
+	glDisable(GL_DEPTH_TEST);
+	g_ezCtx.batch.depth = 0.0f;
+	g_ezCtx.batch.depthLevels = levels + count;
+}
+
+void ezDrawMany(EZobject** objects, int count) {
+	// the software renderer has no textures to switch, so sorting wouldn't gain anything
+	if (g_ezCtx.software.active) {
+		for (int i = 0; i < count; i++) {
+			ezDraw(objects[i]);
+		}
+
+		return;
+	}
+
+	// make room to sort, falling back to drawing in order if there's no memory for it
+	const int chunk = count < EZ_DRAW_MANY_CHUNK ? count : EZ_DRAW_MANY_CHUNK;
+
+	if (g_ezCtx.sortCapacity < chunk) {
+		struct EzSortEntry* entries = realloc(g_ezCtx.sortEntries, sizeof(struct EzSortEntry) * chunk);
+
+		if (entries == NULL) {
+			for (int i = 0; i < count; i++) {
+				ezDraw(objects[i]);
+			}
+
+			return;
+		}
+
+		g_ezCtx.sortEntries = entries;
+		g_ezCtx.sortCapacity = chunk;
+	}
+
+	ezTraceBegin("ezDrawMany");
+
+	for (int start = 0; start < count; start += EZ_DRAW_MANY_CHUNK) {
+		const int remaining = count - start;
+		ezDrawManySorted(objects + start, remaining < EZ_DRAW_MANY_CHUNK ? remaining : EZ_DRAW_MANY_CHUNK);
+	}
+
+	ezTraceEnd();
+}
+
+void ezGetFrameStats(EZframestats* stats) {
+	*stats = g_ezCtx.lastStats;
+}
+
+void ezSetCulling(int enabled) {
+	g_ezCtx.culling = enabled;
+}
+
+// Spatial Index
+
+static int ezCompareInts(const void* a, const void* b) {
+	return *(const int*)a - *(const int*)b;
+}
+
+static unsigned int ezGridHash(const int x, const int y) {
+	return ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u);
+}
+
+// Finds a cell of the grid, adding it if create is set. Returns NULL if it isn't there, or there's no memory to add it.
+static struct EzGridCell* ezGridCell(struct EzGrid* grid, const int x, const int y, const int create) {
+	// kept at most half full, so probes stay short
+	if (create && (grid->cellCount + 1) * 2 > grid->capacity) {
+		const int capacity = grid->capacity ? grid->capacity * 2 : 256;
+		struct EzGridCell* cells = calloc(capacity, sizeof(struct EzGridCell));
+		if (cells == NULL) return NULL;
+
+		for (int i = 0; i < grid->capacity; i++) {
+			if (!grid->cells[i].used) continue;
+
+			unsigned int probe = ezGridHash(grid->cells[i].x, grid->cells[i].y) & (capacity - 1);
+			while (cells[probe].used) probe = (probe + 1) & (capacity - 1);
+			cells[probe] = grid->cells[i];
+		}
+
+		free(grid->cells);
+		grid->cells = cells;
+		grid->capacity = capacity;
+	}
+
+	if (grid->capacity == 0) {
+		return NULL;
+	}
+
+	for (unsigned int probe = ezGridHash(x, y) & (grid->capacity - 1);; probe = (probe + 1) & (grid->capacity - 1)) {
+		struct EzGridCell* cell = &(grid->cells[probe]);
+
+		if (cell->used && cell->x == x && cell->y == y) {
+			return cell;
+		}
+
+		if (!cell->used) {
+			if (!create) return NULL;
+
+			cell->used = 1;
+			cell->x = x;
+			cell->y = y;
+			grid->cellCount++;
+			return cell;
+		}
+	}
+}
+
+// Adds an entry to a cell's list. Returns 0 if there's no memory for it.
+static int ezGridListAdd(struct EzGridCell* cell, const int index) {
+	if (cell->count == cell->capacity) {
+		const int capacity = cell->capacity ? cell->capacity * 2 : 8;
+		int* entries = realloc(cell->entries, sizeof(int) * capacity);
+		if (entries == NULL) return 0;
+
+		cell->entries = entries;
+		cell->capacity = capacity;
+	}
+
+	cell->entries[cell->count++] = index;
+	return 1;
+}
+
+static void ezGridListRemove(struct EzGridCell* cell, const int index) {
+	for (int i = 0; i < cell->count; i++) {
+		if (cell->entries[i] == index) {
+			cell->entries[i] = cell->entries[--cell->count];
+			return;
+		}
+	}
+}
+
+static int ezGridCoordinate(const double position) {
+	const double cell = floor(position / EZ_GRID_CELL_SIZE);
+	if (cell < -EZ_GRID_LIMIT) return -EZ_GRID_LIMIT;
+	if (cell > EZ_GRID_LIMIT) return EZ_GRID_LIMIT;
+	return (int)cell;
+}
+
+// Works out the cells an area overlaps, given as left, bottom, right, top
+static struct EzGridBounds ezGridBoundsOf(const double area[4]) {
+	struct EzGridBounds bounds;
+	bounds.x0 = ezGridCoordinate(area[0]);
+	bounds.y0 = ezGridCoordinate(area[1]);
+	bounds.x1 = ezGridCoordinate(area[2]);
+	bounds.y1 = ezGridCoordinate(area[3]);
+	bounds.large = (long long)(bounds.x1 - bounds.x0 + 1) * (bounds.y1 - bounds.y0 + 1) > EZ_GRID_MAX_CELLS;
+	return bounds;
+}
+
+// Puts an entry in the cells it overlaps. The area is what it covers: left, bottom, right, top.
+// Sets the grid's failed flag if there's no memory for it.
+static void ezGridAdd(struct EzGrid* grid, const int index, const struct EzGridBounds* bounds, const double area[4]) {
+	int added = 1;
+
+	if (bounds->large) {
+		added = ezGridListAdd(&(grid->large), index);
+	} else {
+		for (int y = bounds->y0; y <= bounds->y1; y++) {
+			for (int x = bounds->x0; x <= bounds->x1; x++) {
+				struct EzGridCell* cell = ezGridCell(grid, x, y, 1);
+				added = added && cell && ezGridListAdd(cell, index);
+			}
+		}
+	}
+
+	if (!added) {
+		grid->failed = 1;
+	}
+
+	if (!grid->extents) {
+		memcpy(grid->area, area, sizeof(grid->area));
+		grid->extents = 1;
+	}
+
+	if (area[0] < grid->area[0]) grid->area[0] = area[0];
+	if (area[1] < grid->area[1]) grid->area[1] = area[1];
+	if (area[2] > grid->area[2]) grid->area[2] = area[2];
+	if (area[3] > grid->area[3]) grid->area[3] = area[3];
+}
+
+// Empties a grid, keeping its memory
+static void ezGridClear(struct EzGrid* grid) {
+	for (int i = 0; i < grid->capacity; i++) {
+		free(grid->cells[i].entries);
+	}
+
+	if (grid->capacity > 0) {
+		memset(grid->cells, 0, sizeof(struct EzGridCell) * grid->capacity);
+	}
+
+	grid->cellCount = 0;
+	grid->large.count = 0;
+	grid->extents = 0;
+	grid->failed = 0;
+}
+
+// Puts an entry of the scene in the cells it overlaps. The area is the rectangle it fills in the world.
+// Anything missing from the grid would go undrawn, so a failure stops culling until the grid is rebuilt.
+static void ezGridInsert(const int index, const struct EzGridBounds* bounds, const double area[4]) {
+	ezGridAdd(&(g_ezCtx.scene.grid), index, bounds, area);
+	g_ezCtx.scene.bounds[index] = *bounds;
+}
+
+// Takes an entry of the scene out of the grid
+static void ezGridRemove(const int index) {
+	struct EzGrid* grid = &(g_ezCtx.scene.grid);
+	struct EzGridBounds* bounds = &(g_ezCtx.scene.bounds[index]);
+
+	if (bounds->x0 > bounds->x1) {
+		return;
+	}
+
+	if (bounds->large) {
+		ezGridListRemove(&(grid->large), index);
+	} else {
+		for (int y = bounds->y0; y <= bounds->y1; y++) {
+			for (int x = bounds->x0; x <= bounds->x1; x++) {
+				struct EzGridCell* cell = ezGridCell(grid, x, y, 0);
+				if (cell) ezGridListRemove(cell, index);
+			}
+		}
+	}
+
+	bounds->x0 = 1;
+	bounds->x1 = 0;
+}
+
+// Moves an entry of the scene to the cells it now overlaps, if they've changed
+static void ezGridUpdate(const int index) {
+	const int slot = g_ezCtx.scene.slots[index];
+
+	if (slot < 0) {
+		ezGridRemove(index);
+		return;
+	}
+
+	double area[4];
+	ezObjectRect(slot, area);
+	const struct EzGridBounds bounds = ezGridBoundsOf(area);
+	const struct EzGridBounds* old = &(g_ezCtx.scene.bounds[index]);
+
+	if (old->x0 == bounds.x0 && old->y0 == bounds.y0 && old->x1 == bounds.x1 && old->y1 == bounds.y1) {
+		return;
+	}
+
+	ezGridRemove(index);
+	ezGridInsert(index, &bounds, area);
+}
+
+// Empties the grid and puts every entry of the scene back in it
+static void ezGridRebuild(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	ezGridClear(&(scene->grid));
+
+	for (int i = 0; i < scene->count; i++) {
+		scene->bounds[i].x0 = 1;
+		scene->bounds[i].x1 = 0;
+		ezGridUpdate(i);
+	}
+}
+
+// Lists the entries of a cell that overlap an area and haven't been listed yet by this query
+static int ezGridQueryCell(const struct EzGridCell* cell, const double area[4], int count) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+
+	for (int i = 0; i < cell->count; i++) {
+		const int index = cell->entries[i];
+
+		if (scene->seen[index] != scene->query) {
+			scene->seen[index] = scene->query;
+			if (ezObjectOverlaps(scene->slots[index], area)) scene->visible[count++] = index;
+		}
+	}
+
+	return count;
+}
+
+// Finds the entries of the scene that overlap an area, given as left, bottom, right, top.
+// Lists them in scene->visible in draw order, and returns how many there are.
+static int ezGridQuery(const double area[4]) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	struct EzGrid* grid = &(scene->grid);
+
+	if (++scene->query == 0) {
+		memset(scene->seen, 0, sizeof(unsigned int) * scene->capacity);
+		scene->query = 1;
+	}
+
+	if (!grid->extents) {
+		return 0;
+	}
+
+	// no further than anything in the grid reaches
+	const double clipped[4] = {
+		area[0] > grid->area[0] ? area[0] : grid->area[0],
+		area[1] > grid->area[1] ? area[1] : grid->area[1],
+		area[2] < grid->area[2] ? area[2] : grid->area[2],
+		area[3] < grid->area[3] ? area[3] : grid->area[3]
+	};
+	const struct EzGridBounds range = ezGridBoundsOf(clipped);
+
+	int count = ezGridQueryCell(&(grid->large), area, 0);
+
+	if (range.x0 <= range.x1 && range.y0 <= range.y1) {
+		// look up each cell in the range, unless there are fewer cells in the table than that
+		if ((long long)(range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1) <= grid->capacity) {
+			for (int y = range.y0; y <= range.y1; y++) {
+				for (int x = range.x0; x <= range.x1; x++) {
+					const struct EzGridCell* cell = ezGridCell(grid, x, y, 0);
+					if (cell) count = ezGridQueryCell(cell, area, count);
+				}
+			}
+		} else {
+			for (int i = 0; i < grid->capacity; i++) {
+				const struct EzGridCell* cell = &(grid->cells[i]);
+
+				if (cell->used && cell->x >= range.x0 && cell->x <= range.x1 && cell->y >= range.y0 && cell->y <= range.y1) {
+					count = ezGridQueryCell(cell, area, count);
+				}
+			}
+		}
+	}
+
+	qsort(scene->visible, count, sizeof(int), ezCompareInts);
+	return count;
+}
+
+// Whether everything in the grid is inside an area, given as left, bottom, right, top
+static int ezGridWithin(const double area[4]) {
+	const struct EzGrid* grid = &(g_ezCtx.scene.grid);
+
+	return !grid->extents || (grid->area[0] >= area[0] && grid->area[1] >= area[1] && grid->area[2] <= area[2] && grid->area[3] <= area[3]);
+}
+
+static void ezFreeGrid(struct EzGrid* grid) {
+	for (int i = 0; i < grid->capacity; i++) {
+		free(grid->cells[i].entries);
+	}
+
+	free(grid->cells);
+	free(grid->large.entries);
+	memset(grid, 0, sizeof(struct EzGrid));
+}
+
+// Scene
+
+// Grows the scene's lists to hold at least the given number of objects. Returns 0 if there's no memory for it.
+static int ezGrowScene(const int capacity) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+
+	if (capacity <= scene->capacity) {
+		return 1;
+	}
+
+	int newCapacity = scene->capacity ? scene->capacity * 2 : EZ_POOL_INITIAL_CAPACITY;
+	while (newCapacity < capacity) newCapacity *= 2;
+
+#define EZ_GROW_SCENE(field, size) \
+	{ \
+		void* grown = realloc(scene->field, (size) * newCapacity); \
+		if (grown == NULL) return 0; \
+		scene->field = grown; \
+	}
+
+	EZ_GROW_SCENE(slots, sizeof(int));
+	EZ_GROW_SCENE(dirty, sizeof(int));
+	EZ_GROW_SCENE(dirtyFlags, 1);
+	EZ_GROW_SCENE(instances, sizeof(float) * EZ_INSTANCE_SIZE);
+	EZ_GROW_SCENE(bounds, sizeof(struct EzGridBounds));
+	EZ_GROW_SCENE(seen, sizeof(unsigned int));
+	EZ_GROW_SCENE(visible, sizeof(int));
+#undef EZ_GROW_SCENE
+
+	memset(scene->dirtyFlags + scene->capacity, 0, newCapacity - scene->capacity);
+	memset(scene->seen + scene->capacity, 0, sizeof(unsigned int) * (newCapacity - scene->capacity));
+	scene->capacity = newCapacity;
+	return 1;
+}
+
+// Marks an entry of the scene to be uploaded by the next ezDrawScene
+static void ezSceneMarkDirty(const int index) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+
+	if (!scene->dirtyFlags[index]) {
+		scene->dirtyFlags[index] = 1;
+		scene->dirty[scene->dirtyCount++] = index;
+	}
+}
+
+static void ezSceneChanged(const int slot, const int restructure) {
+	const int index = g_ezCtx.objects.sceneIndex[slot];
+
+	if (index >= 0) {
+		ezSceneMarkDirty(index);
+		g_ezCtx.scene.restructure |= restructure;
+	}
+}
+
+// Marks the entries whose image has moved to another texture or place in it since the instances were written.
+// Only those are uploaded again, so images streaming in don't send the whole scene every frame.
+static void ezSceneImagesChanged(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	const struct EzImageTable* table = &(g_ezCtx.images);
+	int changed = 0;
+
+	for (int i = 0; i < scene->count; i++) {
+		const int slot = scene->slots[i];
+		const int image = slot < 0 ? 0 : g_ezCtx.objects.texture[slot];
+
+		// freed images keep their revision, so objects still using one are caught too
+		if (image > 0 && image <= table->capacity && (int)(table->images[image - 1].revision - scene->imageRevision) > 0) {
+			ezSceneMarkDirty(i);
+			changed = 1;
+		}
+	}
+
+	// a new texture can split or join draw calls
+	scene->restructure |= changed;
+	scene->imageRevision = table->revision;
+}
+
+// Adds an entry to the end of the scene's runs, starting a new run if it can't share the last one's draw call
+static void ezSceneAppendRun(const int index) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	const int slot = scene->slots[index];
+	unsigned int texture = 0;
+	int variant = 0;
+
+	// removed objects are drawn as nothing, so they fit in any run
+	if (slot >= 0) {
+		texture = ezImageTexture(g_ezCtx.objects.texture[slot]);
+		variant = (texture ? EZ_VARIANT_TEXTURED : 0) | (ezSoftEdged(slot) ? EZ_VARIANT_FILLETED : 0);
+	}
+
+	struct EzSceneRun* last = scene->runCount > 0 ? &(scene->runs[scene->runCount - 1]) : NULL;
+
+	if (last && (texture == 0 || last->texture == 0 || last->texture == texture)) {
+		last->count++;
+		last->variant |= variant;
+		if (texture) last->texture = texture;
+		return;
+	}
+
+	if (scene->runCount == scene->runCapacity) {
+		const int capacity = scene->runCapacity ? scene->runCapacity * 2 : 16;
+		struct EzSceneRun* runs = realloc(scene->runs, sizeof(struct EzSceneRun) * capacity);
+
+		// draw the rest as best it can; the runs are worked out again next time
+		if (runs == NULL) {
+			scene->restructure = 1;
+			return;
+		}
+
+		scene->runs = runs;
+		scene->runCapacity = capacity;
+	}
+
+	struct EzSceneRun* run = &(scene->runs[scene->runCount++]);
+	run->first = index;
+	run->count = 1;
+	run->texture = texture;
+	run->variant = variant;
+}
+
+// The object's entry is left empty, drawn as nothing until the scene is compacted
+static void ezSceneRemoveSlot(const int slot) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	const int index = g_ezCtx.objects.sceneIndex[slot];
+
+	if (index < 0) {
+		return;
+	}
+
+	scene->slots[index] = -1;
+	scene->removed++;
+	g_ezCtx.objects.sceneIndex[slot] = -1;
+	ezSceneMarkDirty(index);
+}
+
+// Takes the empty entries out of the scene. Everything after the first one moves, so it's all uploaded again.
+static void ezCompactScene(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	int count = 0;
+
+	for (int i = 0; i < scene->count; i++) {
+		const int slot = scene->slots[i];
+
+		if (slot >= 0) {
+			scene->slots[count] = slot;
+			g_ezCtx.objects.sceneIndex[slot] = count;
+			count++;
+		}
+	}
+
+	scene->count = count;
+	scene->removed = 0;
+	scene->uploadAll = 1;
+	scene->restructure = 1;
+
+	// the dirty entries have moved too, so start again
+	for (int i = 0; i < scene->dirtyCount; i++) {
+		scene->dirtyFlags[scene->dirty[i]] = 0;
+	}
+
+	scene->dirtyCount = 0;
+	ezGridRebuild();
+}
+
+// Writes the instance data of an entry of the scene to its copy of the buffer
+static void ezSceneWriteInstance(const int index) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	float* instance = scene->instances + (size_t)EZ_INSTANCE_SIZE * index;
+	const int slot = scene->slots[index];
+
+	if (slot < 0) {
+		// no size and no soft edges: covers no pixels at all
+		memset(instance, 0, sizeof(float) * EZ_INSTANCE_SIZE);
+	} else {
+		ezWriteInstance(instance, slot, ezGetImage(g_ezCtx.objects.texture[slot]), 0.0f, scene->origin);
+	}
+}
+
+// Sends the instances of new and changed objects to the GPU
+static void ezUploadScene(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	const long long stride = (long long)sizeof(float) * EZ_INSTANCE_SIZE;
+
+	ezStateBindArrayBuffer(scene->vbo);
+
+	// a new buffer is needed when the scene outgrows it, and it gets all of the instances
+	if (scene->bufferCapacity < scene->capacity) {
+		glBufferData(GL_ARRAY_BUFFER, stride * scene->capacity, NULL, GL_DYNAMIC_DRAW);
+		scene->bufferCapacity = scene->capacity;
+		scene->uploadAll = 1;
+	}
+
+	if (scene->uploadAll) {
+		for (int i = 0; i < scene->count; i++) {
+			ezSceneWriteInstance(i);
+		}
+
+		if (scene->count > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, stride * scene->count, scene->instances);
+			scene->stats.uploads++;
+		}
+
+		scene->stats.uploaded = scene->count - scene->removed;
+	} else if (scene->dirtyCount > 0) {
+		// upload in order, joining up nearby ranges
+		qsort(scene->dirty, scene->dirtyCount, sizeof(int), ezCompareInts);
+
+		for (int i = 0; i < scene->dirtyCount; i++) {
+			ezSceneWriteInstance(scene->dirty[i]);
+		}
+
+		int start = scene->dirty[0];
+		int end = start + 1;
+
+		for (int i = 1; i <= scene->dirtyCount; i++) {
+			if (i < scene->dirtyCount && scene->dirty[i] - end <= EZ_SCENE_UPLOAD_GAP) {
+				end = scene->dirty[i] + 1;
+				continue;
+			}
+
+			glBufferSubData(GL_ARRAY_BUFFER, stride * start, stride * (end - start), scene->instances + (size_t)EZ_INSTANCE_SIZE * start);
+			scene->stats.uploads++;
+
+			if (i < scene->dirtyCount) {
+				start = scene->dirty[i];
+				end = start + 1;
+			}
+		}
+
+		scene->stats.uploaded = scene->dirtyCount;
+	}
+
+	for (int i = 0; i < scene->dirtyCount; i++) {
+		scene->dirtyFlags[scene->dirty[i]] = 0;
+	}
+
+	scene->dirtyCount = 0;
+	scene->uploadAll = 0;
+}
+
+void ezSceneAdd(EZobject* object) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	const int slot = ezObjectSlot(object);
+	if (slot < 0 || g_ezCtx.objects.sceneIndex[slot] >= 0) return;
+
+	if (!ezGrowScene(scene->count + 1)) {
+		fprintf(stderr, "Ran out of heap memory!\n");
+		return;
+	}
+
+	const int index = scene->count++;
+	scene->slots[index] = slot;
+	// put in the grid along with the other dirty entries
+	scene->bounds[index].x0 = 1;
+	scene->bounds[index].x1 = 0;
+	g_ezCtx.objects.sceneIndex[slot] = index;
+	ezSceneMarkDirty(index);
+
+	if (!scene->restructure) {
+		ezSceneAppendRun(index);
+	}
+}
+
+void ezSceneRemove(EZobject* object) {
+	const int slot = ezObjectSlot(object);
+	if (slot < 0) return;
+
+	ezSceneRemoveSlot(slot);
+}
+
+void ezSceneClear(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+
+	for (int i = 0; i < scene->count; i++) {
+		if (scene->slots[i] >= 0) {
+			g_ezCtx.objects.sceneIndex[scene->slots[i]] = -1;
+		}
+
+		scene->dirtyFlags[i] = 0;
+	}
+
+	scene->count = 0;
+	scene->removed = 0;
+	scene->dirtyCount = 0;
+	scene->runCount = 0;
+	scene->restructure = 0;
+	ezGridRebuild();
+}
+
+// Draws entries first to end - 1 of the scene from its buffer, split wherever they cross into another run
+static void ezDrawSceneRange(int first, const int end) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+
+	// the run holding the first entry
+	int low = 0;
+	int high = scene->runCount - 1;
+
+	while (low < high) {
+		const int middle = (low + high + 1) / 2;
+
+		if (scene->runs[middle].first <= first) {
+			low = middle;
+		} else {
+			high = middle - 1;
+		}
+	}
+
+	for (int i = low; i < scene->runCount && first < end; i++) {
+		const struct EzSceneRun* run = &(scene->runs[i]);
+		const int runEnd = run->first + run->count;
+		const int stop = runEnd < end ? runEnd : end;
+
+		if (stop <= first) continue;
+
+		ezDrawInstances(run->variant, run->texture, scene->vbo, &(scene->pointedOffset), first, stop - first, scene->origin);
+		scene->stats.drawCalls++;
+		first = stop;
+	}
+}
+
+// Draws the visible entries of the scene, listed in draw order
+static void ezDrawSceneVisible(const int count) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+	const int* visible = scene->visible;
+	int ranges = count > 0;
+
+	for (int i = 1; i < count; i++) {
+		if (visible[i] - visible[i - 1] > EZ_SCENE_CULL_GAP) ranges++;
+	}
+
+	// too scattered to draw in place: batch them through the instance ring instead
+	if (ranges > EZ_SCENE_MAX_RANGES) {
+		for (int i = 0; i < count; i++) {
+			ezBatchObject(scene->slots[visible[i]]);
+		}
+
+		ezFlushBatch();
+		return;
+	}
+
+	int start = 0;
+
+	for (int i = 1; i <= count; i++) {
+		if (i == count || visible[i] - visible[i - 1] > EZ_SCENE_CULL_GAP) {
+			ezDrawSceneRange(visible[start], visible[i - 1] + 1);
+			start = i;
+		}
+	}
+
+	g_ezCtx.stats.objects += count;
+}
+
+void ezDrawScene(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
+
+	ezTraceBegin("ezDrawScene");
+
+	// anything already queued must be drawn underneath
+	if (!g_ezCtx.software.active) {
+		ezFlushBatch();
+	}
+
+	scene->stats.uploaded = 0;
+	scene->stats.uploads = 0;
+	scene->stats.drawCalls = 0;
+
+	if (scene->removed > 0 && scene->removed * 2 >= scene->count) {
+		ezCompactScene();
+	}
+
+	// the grid only needs to follow the objects that have changed
+	for (int i = 0; i < scene->dirtyCount; i++) {
+		ezGridUpdate(scene->dirty[i]);
+	}
+
+	// find the objects on screen, unless that's all of them
+	const int live = scene->count - scene->removed;
+	int visible = -1;
+	double view[4];
+	ezViewBounds(view);
+
+	if (g_ezCtx.culling && !scene->grid.failed && !ezGridWithin(view)) {
+		visible = ezGridQuery(view);
+	}
+
+	scene->stats.visible = visible < 0 ? live : visible;
+	scene->stats.culled = live - scene->stats.visible;
+	g_ezCtx.stats.culled += scene->stats.culled;
+
+	if (g_ezCtx.picker.enabled) {
+		for (int i = 0; i < (visible < 0 ? scene->count : visible); i++) {
+			const int slot = scene->slots[visible < 0 ? i : scene->visible[i]];
+			if (slot >= 0) ezPickRecord(slot);
+		}
+	}
+
+	// there's nothing kept between frames to save the software renderer any work
+	if (g_ezCtx.software.active) {
+		for (int i = 0; i < (visible < 0 ? scene->count : visible); i++) {
+			const int slot = scene->slots[visible < 0 ? i : scene->visible[i]];
+			if (slot >= 0) ezRasterizeObject(slot);
+		}
+
+		ezTraceEnd();
+		return;
+	}
 
-// these functions must be declared
-int setup(void); // called for setup
-void draw(void); // called every frame
-void cleanup(void); // called at the end to clean up memory used
+	// images finishing loading change which texture objects are drawn from, and where in it
+	if (scene->imageRevision != g_ezCtx.images.revision) {
+		ezSceneImagesChanged();
+	}
 
-struct EzGlobalContext {
-	GLFWwindow* window;
-	EZkeyfun keyFun;
-	EZmousefun mouseFun;
-	EZclickfun clickFun;
-	EZresizefun resizeFun;
-	EZmemerrfun memErrFun;
-	int winWidth;
-	int winHeight;
-	unsigned int shaderProgram;
-} g_ezCtx;
+	// positions far from the origin lose precision, so once the camera gets far from it, the origin moves to the camera
+	const struct EzCamera* camera = &(g_ezCtx.camera);
 
-// ==================
-// API Implementation
-// ===================
+	if (fabs(camera->x - scene->origin[0]) > EZ_SCENE_REBASE_DISTANCE || fabs(camera->y - scene->origin[1]) > EZ_SCENE_REBASE_DISTANCE) {
+		scene->origin[0] = camera->x;
+		scene->origin[1] = camera->y;
+		scene->uploadAll = 1;
+	}
 
-// Struct 
+	if (scene->vbo == 0) {
+		glGenBuffers(1, &(scene->vbo));
+		glGenVertexArrays(1, &(scene->vao));
+		ezStateBindVertexArray(scene->vao);
+		ezAttachVertexLayout(scene->vbo);
+		scene->pointedOffset = 0;
+	}
 
-struct _EZobject {
-	// internal OpenGL objects
-	int ibo;
-	int vbo;
-	// Colour
-	float r;
-	float g;
-	float b;
-	// Position
-	float x;
-	float y;
-	// Used for the anchor thing. As a proportion of width/height.
-	float anchorX;
-	float anchorY;
-	// Dimensions
-	float width;
-	float height;
-	// Fillet Radius
-	float filletRadius;
-	// Texture
-	int texture;
-};
+	ezStateBindVertexArray(scene->vao);
+	ezUploadScene();
 
-// Window
+	if (scene->restructure) {
+		scene->restructure = 0;
+		scene->runCount = 0;
 
-void ezTitle(const char* title) {
-	glfwSetWindowTitle(g_ezCtx.window, title);
-}
+		for (int i = 0; i < scene->count; i++) {
+			ezSceneAppendRun(i);
+		}
+	}
 
-void ezDisplaySize(const int width, const int height) {
-	g_ezCtx.winWidth = width;
-	g_ezCtx.winHeight = height;
-	glfwSetWindowSize(g_ezCtx.window, width, height);
-	glViewport(0, 0, width, height); // tell gl to adapt accordingly
+	if (visible < 0) {
+		ezDrawSceneRange(0, scene->count);
+		g_ezCtx.stats.objects += live;
+	} else {
+		ezDrawSceneVisible(visible);
+	}
 
-	// set in shader
-	glUniform2f(glGetUniformLocation(g_ezCtx.shaderProgram, "window_size"), (float)width, (float)height);
+	ezTraceEnd();
 }
 
-void ezSetShouldClose(void) {
-	glfwSetWindowShouldClose(g_ezCtx.window, 1);
+void ezGetSceneStats(EZscenestats* stats) {
+	*stats = g_ezCtx.scene.stats;
+	stats->objects = g_ezCtx.scene.count - g_ezCtx.scene.removed;
 }
 
-int ezGetWidth(void) {
-	return g_ezCtx.winWidth;
-}
+// Frees the scene's buffer and lists
+static void ezFreeScene(void) {
+	struct EzScene* scene = &(g_ezCtx.scene);
 
-int ezGetHeight(void) {
-	return g_ezCtx.winHeight;
+	if (scene->vbo) {
+		ezStateBindVertexArray(0);
+		glDeleteVertexArrays(1, &(scene->vao));
+		ezStateForgetBuffer(scene->vbo);
+		glDeleteBuffers(1, &(scene->vbo));
+	}
+
+	free(scene->slots);
+	free(scene->dirty);
+	free(scene->dirtyFlags);
+	free(scene->instances);
+	free(scene->runs);
+	free(scene->bounds);
+	free(scene->seen);
+	free(scene->visible);
+	ezFreeGrid(&(scene->grid));
+	memset(scene, 0, sizeof(struct EzScene));
 }
 
-// Callbacks: Impl (GLFW event handlers)
+// Picking
+// Every object drawn is recorded as it was drawn, and the last frame's objects are put in a grid
+// the first time they're picked from, so finding what's under the mouse only looks at the objects near it.
 
-static void ezKeyHook(GLFWwindow* window, int key, int scancode, int action, int mods) {
-	if (g_ezCtx.keyFun) {
-		g_ezCtx.keyFun(key, action);
+// Makes room for one more element at the end of an array, doubling it when it's full.
+// Returns 0 if there's no memory for it, in which case the array is left as it was.
+static int ezPickReserve(void** array, const int count, int* capacity, const size_t size) {
+	if (count < *capacity) {
+		return 1;
 	}
+
+	const int grown = *capacity ? *capacity * 2 : 1024;
+	void* elements = realloc(*array, size * grown);
+	if (elements == NULL) return 0;
+
+	*array = elements;
+	*capacity = grown;
+	return 1;
 }
 
-static void ezResizeHook(GLFWwindow* window, int width, int height) {
-	ezDisplaySize(width, height);
+// Records an object being drawn, over everything drawn before it this frame, if the program picks
+static void ezPickRecord(const int slot) {
+	const struct EzObjectPool* pool = &(g_ezCtx.objects);
+	const struct EzCamera* camera = &(g_ezCtx.camera);
+	struct EzPicker* picker = &(g_ezCtx.picker);
+	struct EzPickFrame* frame = &(picker->drawing);
 
-	if (g_ezCtx.resizeFun) {
-		g_ezCtx.resizeFun(width, height);
+	if (!picker->enabled || picker->lost) {
+		return;
 	}
-}
 
-static void ezMouseHook(GLFWwindow* window, double mouseX, double mouseY) {
-	if (g_ezCtx.mouseFun) {
-		g_ezCtx.mouseFun(mouseX, (double)g_ezCtx.winHeight - mouseY);
+	// the camera only needs recording again when it's changed
+	const struct EzCamera* last = frame->cameraCount ? &(frame->cameras[frame->cameraCount - 1]) : NULL;
+	const int newCamera = last == NULL || last->x != camera->x || last->y != camera->y || last->zoom != camera->zoom || last->rotation != camera->rotation;
+
+	if (!ezPickReserve((void**)&(frame->entries), frame->count, &(frame->capacity), sizeof(struct EzPickEntry))
+			|| (newCamera && !ezPickReserve((void**)&(frame->cameras), frame->cameraCount, &(frame->cameraCapacity), sizeof(struct EzCamera)))) {
+		fprintf(stderr, "Ran out of heap memory!\n");
+		picker->lost = 1;
+		return;
 	}
-}
 
-static void ezClickHook(GLFWwindow* window, int button, int action, int mods) {
-	if (g_ezCtx.clickFun) {
-		g_ezCtx.clickFun(button, action);
+	if (newCamera) {
+		frame->cameras[frame->cameraCount++] = *camera;
 	}
-}
 
-// Callbacks: API
+	struct EzPickEntry* entry = &(frame->entries[frame->count++]);
+	entry->object = ezMakeHandle(slot);
+	entry->camera = frame->cameraCount - 1;
+	ezObjectRect(slot, entry->area);
+	entry->x = pool->x[slot];
+	entry->y = pool->y[slot];
+	entry->rotation = pool->rotation[slot];
+	entry->scale[0] = pool->scaleX[slot];
+	entry->scale[1] = pool->scaleY[slot];
 
-void ezSetKeyFunction(EZkeyfun function) {
-	g_ezCtx.keyFun = function;
-	glfwSetKeyCallback(g_ezCtx.window, ezKeyHook);
-}
+	const float width = fabsf(pool->width[slot]);
+	const float height = fabsf(pool->height[slot]);
+	const float left = -pool->anchorX[slot] * pool->width[slot];
+	const float bottom = -pool->anchorY[slot] * pool->height[slot];
+	entry->rect[0] = pool->width[slot] < 0.0f ? left - width : left;
+	entry->rect[1] = pool->height[slot] < 0.0f ? bottom - height : bottom;
+	entry->rect[2] = entry->rect[0] + width;
+	entry->rect[3] = entry->rect[1] + height;
 
-void ezSetMouseMoveFunction(EZmousefun function) {
-	g_ezCtx.mouseFun = function;
-	glfwSetCursorPosCallback(g_ezCtx.window, ezMouseHook);
-}
+	// the shaders shrink the radii the same way
+	const float limit = (width < height ? width : height) * 0.5f;
 
-void ezSetClickFunction(EZclickfun function) {
-	g_ezCtx.clickFun = function;
-	glfwSetMouseButtonCallback(g_ezCtx.window, ezClickHook);
+	for (int i = 0; i < 4; i++) {
+		const float radius = pool->radii[slot][i];
+		entry->radii[i] = radius < 0.0f ? 0.0f : (radius > limit ? limit : radius);
+	}
 }
 
-void ezSetResizeFunction(EZresizefun function) {
-	g_ezCtx.resizeFun = function;
-	glfwSetWindowSizeCallback(g_ezCtx.window, ezResizeHook);
+// Makes the objects drawn this frame the ones picked from, ready to record the next frame
+static void ezPickEndFrame(void) {
+	struct EzPicker* picker = &(g_ezCtx.picker);
+	const struct EzPickFrame drawn = picker->drawn;
+
+	picker->drawn = picker->drawing;
+	picker->drawing = drawn;
+	picker->drawing.count = 0;
+	picker->drawing.cameraCount = 0;
+	picker->lost = 0;
+	picker->indexed = 0;
 }
 
-void ezSetOutOfMemoryFunction(EZmemerrfun function) {
-	g_ezCtx.memErrFun = function;
+// Gets the area of the window an object covered as it was drawn: left, bottom, right, top.
+// Bigger than the object if it was drawn at an angle.
+static void ezPickScreenArea(const struct EzPickEntry* entry, double area[4]) {
+	const struct EzCamera* camera = &(g_ezCtx.picker.drawn.cameras[entry->camera]);
+	const double* rect = entry->area;
+
+	for (int i = 0; i < 4; i++) {
+		double screen[2];
+		ezCameraToScreen(camera, rect[i == 1 || i == 2 ? 2 : 0], rect[i >= 2 ? 3 : 1], screen);
+
+		if (i == 0 || screen[0] < area[0]) area[0] = screen[0];
+		if (i == 0 || screen[1] < area[1]) area[1] = screen[1];
+		if (i == 0 || screen[0] > area[2]) area[2] = screen[0];
+		if (i == 0 || screen[1] > area[3]) area[3] = screen[1];
+	}
 }
 
-// Object Functions
+// Whether a point in the world is on an object as it was drawn, rounded corners and all
+static int ezPickHit(const struct EzPickEntry* entry, const double x, const double y) {
+	const double* area = entry->area;
 
-EZobject* ezCreateRect(float width, float height) {
-	EZobject* obj = malloc(sizeof(EZobject));
+	if (x < area[0] || x > area[2] || y < area[1] || y > area[3]) {
+		return 0;
+	}
 
-	if (obj == NULL) {
-		fprintf(stderr, "Ran out of heap memory!\n");
-		int shouldExit = 1;
+	// into the object's own units, relative to its anchor point, where it's an upright rectangle again
+	double u = x - entry->x;
+	double v = y - entry->y;
 
-		if (g_ezCtx.memErrFun) {
-			shouldExit = g_ezCtx.memErrFun();
-		}
+	if (entry->rotation != 0.0f) {
+		const double sine = sin(entry->rotation);
+		const double cosine = cos(entry->rotation);
+		const double turned = u * cosine + v * sine;
+		v = v * cosine - u * sine;
+		u = turned;
+	}
 
-		if (shouldExit) {
-			cleanup();
-			exit(EZ_OUT_OF_HEAP_MEMORY_ERROR_CODE);
-		}
+	// squashed flat, so there's nothing to hit
+	if (entry->scale[0] == 0.0f || entry->scale[1] == 0.0f) {
+		return 0;
+	}
 
-		return NULL;
+	u /= entry->scale[0];
+	v /= entry->scale[1];
+
+	const float* rect = entry->rect;
+
+	if (u < rect[0] || u > rect[2] || v < rect[1] || v > rect[3]) {
+		return 0;
 	}
 
-	// Set colour to white
-	obj->r = 1.0f;
-	obj->b = 1.0f;
-	obj->g = 1.0f;
+	// only the corner on the point's side can leave it out
+	const int right = u * 2.0 > (double)rect[0] + rect[2];
+	const int top = v * 2.0 > (double)rect[1] + rect[3];
+	const double radius = entry->radii[top ? (right ? 2 : 3) : (right ? 1 : 0)];
 
-	// Set position
-	obj->x = 0.0f;
-	obj->y = 0.0f;
+	// how far the point is past the centre of the corner's circle, towards the corner
+	const double dx = right ? u - (rect[2] - radius) : (rect[0] + radius) - u;
+	const double dy = top ? v - (rect[3] - radius) : (rect[1] + radius) - v;
 
-	obj->anchorX = 0.0f;
-	obj->anchorY = 0.0f;
+	return dx <= 0.0 || dy <= 0.0 || dx * dx + dy * dy <= radius * radius;
+}
 
-	// Set data used for fillet
-	obj->width = width;
-	obj->height = height;
-	obj->filletRadius = 0;
+// A point in the window being picked, and where it is in the world through the last camera it was mapped through
+struct EzPickPoint {
+	double x;
+	double y;
+	int camera;
+	double world[2];
+};
 
-	// default texture
-	obj->texture = 0;
-
-	// the code for this used to be bad, but isn't anymore. *do* do this
-	// (i used to create an object for every draw call)
-	glGenBuffers(1, &(obj->vbo));
-	glGenBuffers(1, &(obj->ibo));
-
-	// Vertex Coords	UV Coords
-	const float vertices[16] = {
-		0, height,		0, 1,
-		0, 0,			0, 0,
-		width, 0,		1, 0,
-		width, height,	1, 1
-	};
+// Checks one entry for ezPickAt, adding its object to the list if it's hit and hasn't been deleted since.
+// Returns the number of objects found so far.
+static int ezPickTest(const int index, struct EzPickPoint* point, EZobject** objects, const int max, int found) {
+	const struct EzPickEntry* entry = &(g_ezCtx.picker.drawn.entries[index]);
 
-	glBindBuffer(GL_ARRAY_BUFFER, &(obj->vbo));
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_DYNAMIC_DRAW);
-	
-	const int indices[6] = {
-		0, 2, 1, /* clockwise |\ */
-		0, 3, 2 /* clockwise \| */
-	};
+	// the camera rarely changes between objects, so the point is only mapped again when it does
+	if (entry->camera != point->camera) {
+		point->camera = entry->camera;
+		ezCameraToWorld(&(g_ezCtx.picker.drawn.cameras[entry->camera]), point->x, point->y, point->world);
+	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, &(obj->ibo));
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), &indices, GL_STATIC_DRAW);
+	if (!ezPickHit(entry, point->world[0], point->world[1]) || ezHandleSlot(entry->object) < 0) {
+		return found;
+	}
 
-	// unbind buffers
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	if (found < max) {
+		objects[found] = entry->object;
+	}
 
-	return obj;
+	return found + 1;
 }
 
-EZobject* ezCreateCircle(float radius) {
-	// create object via ezCreateRect
-	EZobject* result = ezCreateRect(radius * 2, radius * 2);
-	// anchor in centre
-	ezAnchor(result, 0.5f, 0.5f);
-	// set fillet
-	ezFilletRadius(result, radius);
-	// return
-	return result;
-}
+// Finds the objects drawn in the last frame under a point in the window, topmost first. Stores up to max of them in objects.
+// Returns how many there are in all, or stops at max if first is set.
+static int ezPickAt(const double x, const double y, EZobject** objects, const int max, const int first) {
+	struct EzPicker* picker = &(g_ezCtx.picker);
+	const struct EzPickFrame* drawn = &(picker->drawn);
+	struct EzGrid* grid = &(picker->grid);
+	struct EzPickPoint point = { x, y, -1, { 0.0, 0.0 } };
 
-void ezAnchor(EZobject* object, float x, float y) {
-	object->anchorX = x;
-	object->anchorY = y;
-}
+	// programs that pick pay for recording from now on
+	picker->enabled = 1;
 
-void ezMove(EZobject* object, float x, float y) {
-	object->x = x;
-	object->y = y;
-}
+	if (!picker->indexed) {
+		picker->indexed = 1;
+		ezGridClear(grid);
 
-void ezResize(EZobject* object, float width, float height) {
-	// set properties
-	object->width = width;
-	object->height = height;
-
-	// update buffer data
-	glBindBuffer(GL_ARRAY_BUFFER, &(object->vbo));
-
-	const float vertices[4 * 4] = {
-		0.0f, height, 0.0f, 1.0f,
-		0.0f, 0.0f, 0.0f, 0.0f,
-		width, 0.0f, 1.0f, 0.0f,
-		width, height, 1.0f, 1.0f
-	};
+		for (int i = 0; i < drawn->count; i++) {
+			double area[4];
+			ezPickScreenArea(&(drawn->entries[i]), area);
+			const struct EzGridBounds bounds = ezGridBoundsOf(area);
+			ezGridAdd(grid, i, &bounds, area);
+		}
+	}
 
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
+	int found = 0;
 
-void ezColour(EZobject* object, float r, float g, float b) {
-	object->r = r;
-	object->g = g;
-	object->b = b;
+	// without a whole grid, every object is checked, from the top
+	if (grid->failed) {
+		for (int i = drawn->count - 1; i >= 0 && !(first && found >= max); i--) {
+			found = ezPickTest(i, &point, objects, max, found);
+		}
+
+		return found;
+	}
+
+	const struct EzGridCell* cell = ezGridCell(grid, ezGridCoordinate(x), ezGridCoordinate(y), 0);
+	const struct EzGridCell* large = &(grid->large);
+	// both lists are in draw order, so they're merged from the end
+	int c = cell ? cell->count - 1 : -1;
+	int l = large->count - 1;
+
+	while ((c >= 0 || l >= 0) && !(first && found >= max)) {
+		const int index = l < 0 || (c >= 0 && cell->entries[c] > large->entries[l]) ? cell->entries[c--] : large->entries[l--];
+		found = ezPickTest(index, &point, objects, max, found);
+	}
+
+	return found;
 }
 
-void ezFilletRadius(EZobject* object, float radius) {
-	object->filletRadius = radius;
+EZobject* ezPick(double x, double y) {
+	EZobject* object = NULL;
+	ezPickAt(x, y, &object, 1, 1);
+	return object;
 }
 
-void ezTexture(EZobject* object, int image) {
-	object->texture = image;
+int ezPickAll(double x, double y, EZobject** objects, int max) {
+	return ezPickAt(x, y, objects, max < 0 ? 0 : max, 0);
 }
 
-void ezDelete(EZobject* object) {
-	// delete from GL memory
-	glDeleteBuffers(1, &(object->vbo));
-	glDeleteBuffers(1, &(object->ibo));
+static void ezFreePicker(void) {
+	struct EzPicker* picker = &(g_ezCtx.picker);
 
-	// free from heap
-	free(object);
+	free(picker->drawing.entries);
+	free(picker->drawing.cameras);
+	free(picker->drawn.entries);
+	free(picker->drawn.cameras);
+	ezFreeGrid(&(picker->grid));
+	memset(picker, 0, sizeof(struct EzPicker));
 }
 
-// Image Functions
+// Software Rendering
 
-int ezLoadImage(const char* fileName) {
-	// ===========
-	// STEP 1: create opengl tex obj 
-	// ============
+// Switches to the requested renderer and clears the software colour buffer if it's in use. Called at the start of each frame.
+static void ezStartSoftwareFrame(void) {
+	struct EzSoftwareRenderer* software = &(g_ezCtx.software);
 
-	// generate opengl texture object
-	int texture;
-	glGenTextures(1, &texture);
-	// bind texture
-	glBindTexture(GL_TEXTURE_2D, texture);
+	if (software->requested == EZ_RENDERER_SOFTWARE && !software->active) {
+		if (!software->initialised) {
+			software->initialised = ezSoftwareInit();
+		}
 
-	// only use NEAREST NEIGHBOUR!
-	// if you want your textures interpolated feel free to change this to GL_LINEAR / GL_LINEAR_MIPMAP_LINEAR tho
-	// could make interpolation method a parameter in a future version, or make another function to set it
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		software->active = software->initialised && ezSoftwareResize(g_ezCtx.winWidth, g_ezCtx.winHeight);
 
-	// ===========
-	// STEP 2: actually load image
-	// ============
-	
-	// load imgae from file
-	int width, height, channels;
-	stbi_set_flip_vertically_on_load(1);
-	unsigned char* data = stbi_load(fileName, &width, &height, &channels, 0);
+		if (!software->active) {
+			fprintf(stderr, "Ran out of heap memory! Staying with OpenGL rendering.\n");
+			software->requested = EZ_RENDERER_OPENGL;
+		}
+	} else if (software->requested == EZ_RENDERER_OPENGL) {
+		software->active = 0;
+	}
 
-	// load image data to opengl texture object and gen mipmap
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	if (software->active) {
+		ezSoftwareClear(g_ezCtx.clearColour[0], g_ezCtx.clearColour[1], g_ezCtx.clearColour[2]);
+	}
+}
 
-	// free loaded image data
-	stbi_image_free(data);
+#ifndef EZ_HEADLESS
+static void ezShowSoftwareFrame(void) {
+	struct EzSoftwareRenderer* software = &(g_ezCtx.software);
+	const int width = g_ezCtx.winWidth;
+	const int height = g_ezCtx.winHeight;
 
-	// unbind texture
-	// probably not necessary
-	glBindTexture(GL_TEXTURE_2D, 0);
+	if (software->framebuffer == 0) {
+		glGenFramebuffers(1, &(software->framebuffer));
+	}
 
-	return texture;
-}
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, software->framebuffer);
 
-void ezFreeImage(int image) {
-	glDeleteTextures(1, &image);
-}
+	if (software->textureWidth != width || software->textureHeight != height) {
+		if (software->texture) {
+			ezDeleteTexture(software->texture);
+		}
 
-// Draw Functions
+		software->texture = ezCreateTexture(width, height, ezSoftwarePixels());
+		software->textureWidth = width;
+		software->textureHeight = height;
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, software->texture, 0);
+	} else {
+		ezStateBindTexture(0, software->texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, ezSoftwarePixels());
+	}
 
-void ezBackgroundColour(float r, float g, float b) {
-	glClearColor(r, g, b, 1.0f);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 }
+#endif
 
-void ezDraw(EZobject *object) {
-	glBindBuffer(GL_ARRAY_BUFFER, &(object->vbo));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, &(object->ibo));
-
-	// Attach buffer data
-	// (location = 0) in vec2 pos
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, sizeof(float) * 0);
-	glEnableVertexAttribArray(0);
-	// (location = 1) in vec2 uv
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 4, sizeof(float) * 2);
-	glEnableVertexAttribArray(1);
-
-	// Set uniforms
+static void ezFreeSoftwareRenderer(void) {
+	struct EzSoftwareRenderer* software = &(g_ezCtx.software);
 
-	glUniform3f(glGetUniformLocation(g_ezCtx.shaderProgram, "colour"), object->r, object->g, object->b);
-	glUniform2f(glGetUniformLocation(g_ezCtx.shaderProgram, "position"), object->x - object->anchorX * object->width, object->y - object->anchorY * object->height);
+	if (software->texture) {
+		ezDeleteTexture(software->texture);
+	}
 
-	glUniform2f(glGetUniformLocation(g_ezCtx.shaderProgram, "dimensions"), object->width, object->height);
-	glUniform1f(glGetUniformLocation(g_ezCtx.shaderProgram, "filletRadius"), object->filletRadius);
+	if (software->framebuffer) {
+		glDeleteFramebuffers(1, &(software->framebuffer));
+	}
 
-	// Texture
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, object->texture);
-	// 0 is treated as false, all else is true. Thus, we can define "hasTexture" as the id of the texture
-	glUniform1i(glGetUniformLocation(g_ezCtx.shaderProgram, "hasTexture"), object->texture);
-	// gotta set the sampler to use active texture 0
-	glUniform1i(glGetUniformLocation(g_ezCtx.shaderProgram, "textureSampler"), 0);
+	ezSoftwareFree();
+	memset(software, 0, sizeof(struct EzSoftwareRenderer));
+}
 
-	//glDrawElements(GL_TRIANGLES, sizeof(indices) / sizeof(int), GL_UNSIGNED_INT, 0);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+void ezSetRenderer(int renderer) {
+	g_ezCtx.software.requested = renderer;
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	// the software renderer needs its own copy of images, so keep them from now on
+	if (renderer == EZ_RENDERER_SOFTWARE) {
+		g_ezCtx.images.keepPixels = 1;
+	}
 }
 
-// TODO compound objects.
-//void ezDrawArrays(EZobject* objects, int length) {
-//	for (int i = 0; i < length; i++) {
-//		ezDraw(&(objects[i]));
-//	}
-//}
+void ezReadPixels(unsigned char* pixels) {
+	if (g_ezCtx.software.active) {
+		ezSoftwareFlush();
+		memcpy(pixels, ezSoftwarePixels(), (size_t)g_ezCtx.winWidth * g_ezCtx.winHeight * 4);
+	} else {
+		ezFlushBatch();
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, g_ezCtx.winWidth, g_ezCtx.winHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+}
 
 int ezGetOpenGLError(void) {
-	// todo move this to separate method?
 	return glGetError();
 }
 
@@ -378,181 +5768,146 @@ int ezGetOpenGLError(void) {
 //    Main
 //=============
 
-// Taken from another project of mine
-// Checks the given shader for errors.
-// If errors are found, the error log is displayed, the window is destroyed, GLFW is shut down, and the program terminates with status -1.
-static void ezCheckShaderErrors(const GLFWwindow* window, const int shader, const char* shaderType);
-
-int main(void) {
+int main(int argc, char** argv) {
 	printf("Starting Up...\n");
 
-	// startup
-	if (!glfwInit()) {
-		printf("GLFW Failed to Initialise.");
-		return EZ_GLFW_INIT_ERROR_CODE;
-	}
+#ifdef EZ_HEADLESS
+	ezReadHeadlessOptions(argc, argv);
+#else
+	// windowed builds take no options
+	(void)argc;
+	(void)argv;
+#endif
 
-	g_ezCtx.window = glfwCreateWindow(500, 500, "Window", NULL, NULL);
-	glfwMakeContextCurrent(g_ezCtx.window);
+	// startup
+	const int startupError = ezCreateContext();
 
-	if (glewInit() != GLEW_OK) {
-		printf("GLEW Failed to Initialise.");
-		glfwDestroyWindow(g_ezCtx.window);
-		glfwTerminate();
-		return EZ_GLEW_INIT_ERROR_CODE;
+	if (startupError != EZ_SUCCESS_ERROR_CODE) {
+		return startupError;
 	}
 
-	// shaders
-	printf("Compiling Shaders.\n");
-
-	const char* vertexShaderSource =
-		"#version 330 core\n"
-		"layout(location = 0) in vec2 vertexPosition;\n"
-		"layout(location = 1) in vec2 uv;\n"
-
-		"out vec2 posPass;\n"
-		"out vec2 uvPass;\n"
-
-		"uniform vec2 window_size;\n"
-		"uniform vec2 position;\n"
-
-		"void main() {\n"
-		"  posPass = vertexPosition;\n" // position relative to the shape. Will be interpolated for each pixel when passed to the fragment shader
-		"  uvPass = uv;\n"
-		// map from 0,0,WIDTH,HEIGHT to -1,1,-1,1.
-		"  vec2 half_size = window_size * 0.5;\n"
-		"  gl_Position = vec4(((vertexPosition + position) / half_size) - 1, 0.0, 1.0);\n"
-		"}";
-
-	unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	ezCheckShaderErrors(g_ezCtx.window, vertexShader, "vertex");
-
-	const char* fragmentShaderSource =
-		"#version 330 core\n"
-
-		"in vec2 posPass;\n"
-		"in vec2 uvPass;\n"
-
-		"uniform vec3 colour;\n"
-
-		"uniform vec2 dimensions;\n"
-		"uniform float filletRadius;\n"
-
-		"uniform bool hasTexture;\n"
-		"uniform sampler2D textureSampler;\n"
-
-		"void main() {\n"
-		// detect edge boxes that encompass the fillet curves,
-		// then if within one of those boxes do a squrared-distance calculation to the inside corner
-		// this creates a smooth arc around a corner
-		// ... so long as the fillet radius is <= half length of shortest dimension
-		"  if (posPass.x <= filletRadius) {\n"
-		"    float dx = posPass.x - filletRadius;\n"
-
-		"    if (posPass.y <= filletRadius) {\n"
-		"      float dy = posPass.y - filletRadius;\n"
-		"      if (dx * dx + dy * dy > filletRadius * filletRadius) discard;\n"
-		"    }\n"
-		"    else if (posPass.y >= dimensions.y - filletRadius) {\n"
-		"      float dy = posPass.y - (dimensions.y - filletRadius);\n"
-		"      if (dx * dx + dy * dy > filletRadius * filletRadius) discard;\n"
-		"    }\n"
-		"  }\n"
-		// and the other two corners...
-		"  else if (posPass.x >= dimensions.x - filletRadius) {\n"
-		"    float dx = posPass.x - (dimensions.x - filletRadius);\n"
-
-		"    if (posPass.y <= filletRadius) {\n"
-		"      float dy = posPass.y - filletRadius;\n"
-		"      if (dx * dx + dy * dy > filletRadius * filletRadius) discard;\n"
-		"    }\n"
-		"    else if (posPass.y >= dimensions.y - filletRadius) {\n"
-		"      float dy = posPass.y - (dimensions.y - filletRadius);\n"
-		"      if (dx * dx + dy * dy > filletRadius * filletRadius) discard;\n"
-		"    }\n"
-		"  }\n"
-
-		// If Texture, use that
-		"  if (hasTexture) {\n"
-		"    gl_FragColor = texture(textureSampler, uvPass) * vec4(colour, 1.0);\n"
-		"    if (gl_FragColor.a <= 0.0) discard;\n"
-		"  } else {\n"
-		// Else, use colour
-		"    gl_FragColor = vec4(colour, 1.0);\n"
-		"  }\n"
-		"}";
-
-	unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	ezCheckShaderErrors(g_ezCtx.window, fragmentShader, "fragment");
-
-	printf("Linking Shaders.\n");
-
-	unsigned int shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	int success;
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+	ezInitDebugOutput();
 
-	if (!success) {
-		printf("Shader Link Error");
-		char infoLog[512];
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		printf(": %s\n", infoLog);
-		glfwDestroyWindow(g_ezCtx.window);
-		glfwTerminate();
-		return EZ_LINK_ERROR_CODE;
+	if (!ezInitBatch()) {
+		fprintf(stderr, "Ran out of heap memory!\n");
+		ezDestroyContext();
+		return EZ_OUT_OF_HEAP_MEMORY_ERROR_CODE;
 	}
 
-	// clean up memory
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	// Use the Shader
-	glUseProgram(shaderProgram);
-	g_ezCtx.shaderProgram = shaderProgram;
+	ezInitGpuTimer();
+	ezInitTrace();
 
 	// configure view port default & null default callbacks
 	ezDisplaySize(500, 500);
 	g_ezCtx.keyFun = NULL;
 	g_ezCtx.memErrFun = NULL;
+	g_ezCtx.glErrorFun = NULL;
+
+	// the object pool starts out empty and grows on first use
+	g_ezCtx.objects.freeHead = -1;
+	g_ezCtx.objects.freeTail = -1;
+	g_ezCtx.culling = 1;
+	g_ezCtx.camera.zoom = 1.0f;
+	g_ezCtx.camera.cosine = 1.0;
+
+	// images are stored bottom row first, the way OpenGL expects. This applies to every thread.
+	stbi_set_flip_vertically_on_load(1);
+	ezSetImageUploadBudget(EZ_DEFAULT_IMAGE_UPLOAD_BUDGET);
+	ezInitImages();
 
 	// Default Clear Colour
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	// only soft edges are blended, switched on and off per batch. The window stays opaque.
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
 	// Set Up
 	if (setup() != EZ_OK) {
-		glfwDestroyWindow(g_ezCtx.window);
-		glfwTerminate();
+		ezDestroyContext();
 		return EZ_GENERIC_ERROR_CODE;
 	}
 
+	// shaders. Built after setup so it can turn on the cache.
+	// The variant that can draw anything is built up front (unless setup drew something), so a broken shader is caught at startup.
+	printf("Compiling Shaders.\n");
+
+	if (g_ezCtx.programs[EZ_VARIANT_ALL].id == 0 && !ezBuildProgram(EZ_VARIANT_ALL)) {
+		ezDestroyContext();
+		return EZ_LINK_ERROR_CODE;
+	}
+
+	if (g_ezCtx.shaderCache.stats.hits > 0) {
+		printf("Loaded shaders from the cache, saving %.1f ms.\n", g_ezCtx.shaderCache.stats.savedTime);
+	}
+
 	printf("Initialised Successfully. Starting Main Loop.\n");
 
 	// main lp
 
-	while (!glfwWindowShouldClose(g_ezCtx.window)) {
-		glClear(GL_COLOR_BUFFER_BIT);
+	while (!ezShouldClose()) {
+		g_ezCtx.frameStart = ezTime();
+		ezProfileStartFrame();
+		ezGpuStartFrame();
+#ifdef EZ_CHECK_UNIFORMS
+		for (int variant = 0; variant < EZ_VARIANT_COUNT; variant++) {
+			if (g_ezCtx.programs[variant].id) {
+				ezCheckUniforms(&(g_ezCtx.programs[variant]));
+			}
+		}
+#endif
+		// depth goes with the colour, so ezDrawMany has the whole depth range to itself each frame
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		g_ezCtx.batch.depthLevels = 0;
+		ezStartSoftwareFrame();
+		ezGpuStamp(EZ_GPU_STAMP_CLEAR, NULL);
+		ezProfilePhase(EZ_PHASE_CLEAR);
+
+		ezUploadLoadedImages();
+		ezProfilePhase(EZ_PHASE_UPLOAD);
 
 		draw();
 
-		glfwSwapBuffers(g_ezCtx.window);
-		glfwPollEvents();
+		if (g_ezCtx.profiler.overlay) {
+			ezDrawProfilerOverlay();
+		}
+
+		ezProfilePhase(EZ_PHASE_DRAW);
+
+		ezEndFrame();
+		ezGpuSubmitted();
+		ezProfilePhase(EZ_PHASE_SUBMIT);
+
+		ezPresent();
+		ezGpuStamp(EZ_GPU_STAMP_PRESENT, NULL);
+		ezProfilePhase(EZ_PHASE_PRESENT);
+
+		ezPollEvents();
+		ezProfilePhase(EZ_PHASE_EVENTS);
+		ezProfileEndFrame();
+		ezTraceEndFrame();
+		ezPollOpenGLErrors();
 	}
 
-	glfwDestroyWindow(g_ezCtx.window);
-	glfwTerminate();
+#ifdef EZ_HEADLESS
+	ezReportHeadless();
+#endif
+
+	ezStopImageLoader();
+	ezFreeTrace();
+	ezFreeImages();
+	ezFreeSoftwareRenderer();
+	ezFreeGpuTimer();
+	ezFreeScene();
+	ezFreePicker();
+	ezFreeBatch();
+	ezFreePrograms();
+	ezFreePool();
+	ezDestroyContext();
 	return EZ_SUCCESS_ERROR_CODE;
 }
 
 // Checks the given shader for errors.
 // If errors are found, the error log is displayed, the window is destroyed, GLFW is shut down, and the program terminates with status -1.
-static void ezCheckShaderErrors(const GLFWwindow* window, const int shader, const char* shaderType) {
+static void ezCheckShaderErrors(const int shader, const char* shaderType) {
 	int success;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 
@@ -563,8 +5918,7 @@ static void ezCheckShaderErrors(const GLFWwindow* window, const int shader, cons
 		glGetShaderInfoLog(shader, 512, NULL, infoLog);
 		printf(": %s\n", infoLog);
 
-		glfwDestroyWindow(window);
-		glfwTerminate();
+		ezDestroyContext();
 		exit(EZ_SHADER_ERROR_CODE);
 	}
 }
\ No newline at end of file
@@ -5,6 +5,15 @@
 // 
 // For the accompanying mathematics utility header, see ezmaths.h
 //
+// Headless builds:
+// Define EZ_HEADLESS to draw offscreen through EGL instead of opening a window, e.g. on machines with no display or GPU
+// (Mesa's llvmpipe works). Link against EGL, and a GLEW built with GLEW_EGL. GLFW is only needed for its header.
+// The program runs setup and draw as normal for a set number of frames, then prints how long the frames took.
+// Command line options:
+//   --frames=N  draw N frames (default 300)
+//   --dump=N    save every Nth frame to frame_#####.ppm in the working directory
+// There is no input in headless builds, so the key, mouse and click functions are never run.
+//
 // Author: Mekal Covic
 //
 
@@ -31,18 +40,136 @@ extern "C" {
 #define EZ_SHADER_ERROR_CODE 10
 #define EZ_LINK_ERROR_CODE 11
 #define EZ_GLFW_INIT_ERROR_CODE 69
+#define EZ_EGL_INIT_ERROR_CODE 70
 #define EZ_GLEW_INIT_ERROR_CODE 420
 #define EZ_OUT_OF_HEAP_MEMORY_ERROR_CODE 690
 
+#define EZ_RENDERER_OPENGL 0
+#define EZ_RENDERER_SOFTWARE 1
+
+// How serious an OpenGL message is. See ezSetOpenGLErrorFunction()
+#define EZ_GL_SEVERITY_NOTIFICATION 0 // information, such as where a buffer was put
+#define EZ_GL_SEVERITY_LOW 1 // minor performance warnings
+#define EZ_GL_SEVERITY_MEDIUM 2 // major performance warnings, and use of deprecated behaviour
+#define EZ_GL_SEVERITY_HIGH 3 // errors
+
 typedef void (*EZkeyfun)(int key, int action);
 typedef int (*EZmemerrfun)(void);
 typedef void (*EZresizefun)(int width, int height);
 typedef void (*EZmousefun)(double mouseX, double mouseY);
 typedef void (*EZclickfun)(int button, int action);
+typedef void (*EZimagefun)(int image, int success);
+typedef void (*EZglerrorfun)(int severity, const char* message, const char* callSite);
 
 struct _EZobject;
 typedef struct _EZobject EZobject;
 
+// Rendering statistics for a single frame. See ezGetFrameStats()
+typedef struct {
+	int objects; // number of objects drawn
+	int batches; // number of batches submitted to OpenGL
+	int flushes; // number of batches submitted before the end of the frame, due to a texture change or a full batch
+	int drawCalls; // number of OpenGL draw calls issued
+	int stateCalls; // number of OpenGL state changes (binds, uniforms) issued
+	int elidedStateCalls; // number of OpenGL state changes skipped because they would not have changed anything
+	int culled; // number of objects not drawn because they were entirely outside the window
+} EZframestats;
+
+// Statistics about how well images are packed into atlas pages. See ezGetAtlasStats()
+typedef struct {
+	int pages; // number of atlas pages (OpenGL textures) in use
+	int images; // number of images packed into the pages
+	double fillRatio; // proportion of the total page area holding image pixels, from 0 to 1
+	long long usedPixels; // pixels holding images
+	long long paddingPixels; // pixels used by the gutters around images
+	long long wastedPixels; // pixels lost to gaps in the packing or held by images that have since been freed
+} EZatlasstats;
+
+// Statistics about reuse of loaded images. See ezGetImageCacheStats()
+typedef struct {
+	int hits; // number of loads that reused an image already in memory
+	int misses; // number of loads that had to read the image in
+	int evictions; // number of unused images freed to stay within the memory budget
+	int images; // number of images in use
+	int unreferencedImages; // number of images freed by the program but kept in case they're loaded again
+	long long residentBytes; // estimated GPU memory held by all of the above images
+} EZimagecachestats;
+
+// Statistics about the shader program cache. See ezSetShaderCacheDirectory()
+typedef struct {
+	int hits; // number of shader programs loaded from the cache
+	int misses; // number of shader programs compiled from source
+	double loadTime; // milliseconds spent loading programs from the cache
+	double compileTime; // milliseconds spent compiling programs
+	double savedTime; // milliseconds saved by loading programs instead of compiling them, going by how long they took to compile before
+} EZshadercachestats;
+
+// Statistics about the scene. See ezDrawScene()
+typedef struct {
+	int objects; // number of objects in the scene
+	int uploaded; // number of objects the last ezDrawScene sent to the GPU, because they were new or had changed
+	int uploads; // number of buffer uploads it took to send them
+	int drawCalls; // number of OpenGL draw calls the last ezDrawScene issued
+	int visible; // number of objects the last ezDrawScene found at least partly inside the window
+	int culled; // number of objects it skipped because they were entirely outside the window
+} EZscenestats;
+
+// Parts of each frame timed by the profiler, in the order they run. See ezGetProfile()
+#define EZ_PHASE_CLEAR 0 // clearing the screen
+#define EZ_PHASE_UPLOAD 1 // uploading images loaded in the background
+#define EZ_PHASE_DRAW 2 // your draw function
+#define EZ_PHASE_SUBMIT 3 // sending the last batches to be drawn
+#define EZ_PHASE_PRESENT 4 // showing the frame, including waiting for vsync and the GPU
+#define EZ_PHASE_EVENTS 5 // handling input, including your callbacks
+#define EZ_PHASE_COUNT 6
+
+// Number of recent frames the profiler keeps
+#define EZ_PROFILE_FRAMES 256
+// Number of buckets in the frame time histogram, and the milliseconds each one covers
+#define EZ_PROFILE_BUCKETS 20
+#define EZ_PROFILE_BUCKET_MS 2.0
+
+// Summary of some times, in milliseconds
+typedef struct {
+	double min;
+	double avg; // mean
+	double p99; // 99th percentile
+	double max;
+} EZtimingstats;
+
+// Timings of recent frames. See ezGetProfile()
+typedef struct {
+	int frames; // number of frames the timings cover
+	EZtimingstats frame; // whole frames
+	EZtimingstats phases[EZ_PHASE_COUNT]; // each phase, indexed by EZ_PHASE_*
+	// number of frames that took [i, i + 1) * EZ_PROFILE_BUCKET_MS milliseconds. The last bucket also has every slower frame.
+	int histogram[EZ_PROFILE_BUCKETS];
+} EZprofile;
+
+// Most draw batches and GPU scopes timed in a frame. See ezGetGpuStats()
+#define EZ_GPU_MAX_BATCHES 64
+#define EZ_GPU_MAX_SCOPES 16
+
+// GPU time taken by a scope. See ezGpuScopeBegin()
+typedef struct {
+	const char* name;
+	double time; // milliseconds
+} EZgpuscope;
+
+// Time the GPU spent on a frame, in milliseconds. See ezGetGpuStats()
+typedef struct {
+	int available; // 0 if the driver can't time the GPU, or no frame has finished yet. Everything else is 0 too.
+	int droppedFrames; // frames left untimed since the last results because the GPU fell too far behind
+	double frame; // the whole frame
+	double clear; // clearing the screen
+	double draw; // every batch drawn, from after the clear until the end of the frame's drawing
+	double present; // showing the frame
+	int batches; // number of batches timed. Any past EZ_GPU_MAX_BATCHES count towards draw only.
+	double batchTimes[EZ_GPU_MAX_BATCHES]; // each batch, in the order they were drawn
+	int scopes; // number of scopes timed
+	EZgpuscope scopeTimes[EZ_GPU_MAX_SCOPES]; // each scope, in the order they began
+} EZgpustats;
+
 // ================
 // Window Functions
 // ================
@@ -64,8 +191,18 @@ int ezGetHeight(void);
 
 // Gets the error code of the latest OpenGL error. If there was no error, returns 0.
 // If you receive an error code, search it up on the internet to see what it means and hope to gosh it's helpful.
+// This makes the CPU wait for OpenGL to catch up, so avoid calling it every frame. ezSetOpenGLErrorFunction is much cheaper.
 int ezGetOpenGLError(void);
 
+// Sets the least severe OpenGL messages to report, from EZ_GL_SEVERITY_NOTIFICATION to EZ_GL_SEVERITY_HIGH.
+// Defaults to EZ_GL_SEVERITY_MEDIUM. Messages below it are dropped by the driver, so they cost nothing.
+void ezSetOpenGLDebugSeverity(int minSeverity);
+
+// Chooses whether OpenGL reports each message during the call that caused it (1), which tells you the call site,
+// or whenever suits the driver (0), which is faster but gives no call site.
+// Defaults to 1 in debug builds (EZ_GL_DEBUG, defined automatically with _DEBUG) and 0 otherwise.
+void ezSetOpenGLDebugSynchronous(int synchronous);
+
 // ==================
 // Callback Functions
 // ==================
@@ -91,12 +228,21 @@ void ezSetClickFunction(EZclickfun function);
 // void functionName(int width, int height)
 void ezSetResizeFunction(EZresizefun function);
   
-// Sets the function to run when a new object cannot be allocated on the heap
+// Sets the function to run when the object pool cannot grow to fit a new object
 // Does not handle other out of memory issues.
 // Must follow the pattern:
 // int functionName(void)
 void ezSetOutOfMemoryFunction(EZmemerrfun function);
 
+// Sets the function to run when OpenGL reports an error or warning. Without one, they're printed to stderr.
+// The call site is the innermost ezTraceBegin scope (the library's own included), or else the phase of the frame,
+// e.g. "draw". It's NULL when messages are reported asynchronously, see ezSetOpenGLDebugSynchronous.
+// Errors are reported as they happen on drivers with KHR_debug. On older drivers, the library checks for errors
+// once a frame, only while a function is set, with a severity of EZ_GL_SEVERITY_HIGH and a call site of "frame".
+// Must follow the pattern:
+// void functionName(int severity, const char* message, const char* callSite)
+void ezSetOpenGLErrorFunction(EZglerrorfun function);
+
 // ===============
 // Image Functions
 // ===============
@@ -104,10 +250,48 @@ void ezSetOutOfMemoryFunction(EZmemerrfun function);
 // Loads the image into GPU memory from the given file
 // If sharing your program with others, make sure to distribute your images with it.
 // The images are relative to the folder the exe is in (same as if you're using fopen and stuff)
+// Small images are packed together into shared atlas textures, see ezSetAtlasEnabled().
+// The id returned is EzGraphix's own, not an OpenGL texture name.
+// Loading a file whose contents are already loaded returns the same id without loading it again.
+// Every load needs its own call to ezFreeImage.
 int ezLoadImage(const char* fileName);
 
-// Frees the image from GPU memory.
+// Starts loading the image from the given file in the background and returns its id straight away.
+// Until it finishes loading, the image draws as plain white (so objects show in their own colour).
+// Loaded images are sent to the GPU a few at a time at the start of each frame, see ezSetImageUploadBudget().
+// If a function is given, it is run once the image is ready. Pass NULL for no function.
+// If the same path is already loaded, its id is returned and the function is run straight away.
+// Must follow the pattern:
+// void functionName(int image, int success)
+int ezLoadImageAsync(const char* fileName, EZimagefun function);
+
+// Waits until every image started with ezLoadImageAsync has finished loading.
+// Useful at the end of a loading screen.
+void ezWaitForImages(void);
+
+// Sets the max time each frame may spend sending images loaded in the background to the GPU, in milliseconds.
+// At least one image is always sent per frame. The default is 2 milliseconds.
+void ezSetImageUploadBudget(double milliseconds);
+
+// Sets whether images loaded from now on may be packed into atlas pages. Enabled by default.
+// Objects using images in the same page can be drawn together, which is much faster than switching textures.
+// Images larger than 512x512 always get their own texture.
+void ezSetAtlasEnabled(int enabled);
+
+// Gets statistics on how full the atlas pages are
+void ezGetAtlasStats(EZatlasstats* stats);
+
+// Sets how much GPU memory, in bytes, images may use before freed images are really freed.
+// Freed images are kept while there's room, least recently used going first, so loading them again is instant.
+// Images still in use are never freed this way. The default is 0, which frees images straight away.
+void ezSetImageMemoryBudget(long long bytes);
+
+// Gets statistics on how often loaded images were reused, and how much memory they hold
+void ezGetImageCacheStats(EZimagecachestats* stats);
+
+// Frees the image from GPU memory, once it has been freed as many times as it was loaded.
 // The image can no longer be used after freeing it.
+// Freeing an image that is still loading in the background cancels it, and its function will not be run.
 void ezFreeImage(int image);
 
 // ================
@@ -116,12 +300,12 @@ void ezFreeImage(int image);
 
 // Creates a rectangle object of the given width and height
 // Positioned from the bottom left.
-// EZ objects are allocated on the heap and in GL memory, so make sure to delete them via ezDelete() when you're done with them
+// EZ objects are kept in a pool in heap memory, so make sure to delete them via ezDelete() when you're done with them
 EZobject* ezCreateRect(float width, float height);
 
 // Creates a circle object of the given radius
 // Positioned from the centre.
-// EZ objects are allocated on the heap and in GL memory, so make sure to delete them via ezDelete() when you're done with them
+// EZ objects are kept in a pool in heap memory, so make sure to delete them via ezDelete() when you're done with them
 EZobject* ezCreateCircle(float radius);
 
 // Sets the anchor position of an object.
@@ -135,25 +319,42 @@ EZobject* ezCreateCircle(float radius);
 //       For example, 0.5 at the vertical centre.
 void ezAnchor(EZobject* object, float x, float y);
 
-// Moves an object to the given position
-void ezMove(EZobject* object, float x, float y);
+// Moves an object to the given position in the world. See ezCameraMove.
+void ezMove(EZobject* object, double x, double y);
 
 // Resizes an object to the given width and height
 void ezResize(EZobject* object, float width, float height);
 
+// Turns an object about its anchor point, anticlockwise in radians. 0 is upright.
+void ezRotate(EZobject* object, float radians);
+
+// Stretches an object about its anchor point, on top of its width and height. 1 in each direction leaves it as it is,
+// and a negative scale flips it. Its rounded corners and border are stretched along with it.
+void ezScale(EZobject* object, float x, float y);
+
 // Sets the colour of an object
 void ezColour(EZobject* object, float r, float g, float b);
 
-// Sets the radius of the edge fillet of an object.
-// Should be <= half the smallest dimension of the object.
+// Sets the radius of the edge fillet of every corner of an object.
+// Radii bigger than half the smallest dimension of the object are drawn as half the smallest dimension.
+// Rounded edges are anti-aliased.
 void ezFilletRadius(EZobject* object, float radius);
 
+// Sets the radius of the edge fillet of each corner of an object separately.
+// Like ezFilletRadius, each is drawn no bigger than half the smallest dimension of the object.
+void ezCornerRadii(EZobject* object, float bottomLeft, float bottomRight, float topRight, float topLeft);
+
+// Gives an object a border of the given width and colour, drawn just inside its edge and following its fillets.
+// The border goes over the object's texture, if it has one. Use a width of 0 for no border.
+void ezBorder(EZobject* object, float width, float r, float g, float b);
+
 // Sets the texture image of this object
 // Use the id of an image loaded with ezLoadImage for an image
 // Use 0 to represent no texture
 void ezTexture(EZobject* object, int image);
 
 // Deletes an object from memory
+// Any use of the object after deleting it is ignored and prints an error.
 void ezDelete(EZobject* object);
 
 // ==============
@@ -164,8 +365,161 @@ void ezDelete(EZobject* object);
 void ezBackgroundColour(float r, float g, float b);
 
 // Draws an object
+// Draws are collected into batches and sent to OpenGL when the texture changes or at the end of the frame,
+// so drawing objects with the same texture one after another is fastest.
 void ezDraw(EZobject* object);
 
+// Draws an array of objects. The result is exactly the same as calling ezDraw on each object in order,
+// but objects are grouped by texture internally so large lists need fewer batches.
+// Lists with rounded or bordered objects are drawn in order, since their blended edges depend on what's under them.
+void ezDrawMany(EZobject** objects, int count);
+
+// Gets the rendering statistics of the last completed frame
+void ezGetFrameStats(EZframestats* stats);
+
+// Sets whether objects entirely outside the window are skipped rather than sent to be drawn. On by default.
+// Objects in the scene are found through a spatial index, so a large scene only costs as much as the part on screen.
+void ezSetCulling(int enabled);
+
+// Sets what draws objects, starting from the next frame:
+//   EZ_RENDERER_OPENGL   = the GPU, through OpenGL (the default)
+//   EZ_RENDERER_SOFTWARE = the CPU, split across several threads. The result is shown in the window as usual.
+// The software renderer draws the same shapes. It needs its own copy of each image, so switch to it before loading any images, e.g. in setup.
+// Images loaded beforehand draw as plain white.
+void ezSetRenderer(int renderer);
+
+// Copies what has been drawn so far this frame into the given buffer, with whichever renderer is in use.
+// The buffer must hold width * height * 4 bytes. Pixels are RGBA, bottom row first.
+void ezReadPixels(unsigned char* pixels);
+
+// Sets the directory compiled shaders are saved in, so later runs can skip compiling them. NULL turns the cache off.
+// The cache is off unless a directory is set. The directory is created when first needed.
+// Must be called in setup to affect the shaders built at startup. Saved shaders are only reused on the same
+// graphics driver; a new driver or library version just compiles and saves them again.
+void ezSetShaderCacheDirectory(const char* directory);
+
+// Gets statistics about the shader cache, including the startup time it saved
+void ezGetShaderCacheStats(EZshadercachestats* stats);
+
+// ================
+// Camera Functions
+// ================
+
+// The camera decides which part of the world is shown in the window. Objects are positioned in the world,
+// which starts out lined up with the window: the camera is at 0, 0 with a zoom of 1 and no rotation.
+// Moving the camera costs the same however many objects there are, and objects stay precisely placed
+// even millions of pixels from 0. Changes apply to objects drawn after them, so the camera can be reset partway
+// through a frame to draw something over the world that stays put in the window.
+
+// Moves the camera to show the given point of the world at the bottom left of the window, before zooming and rotating
+void ezCameraMove(double x, double y);
+
+// Sets how much the camera magnifies the world, about the centre of the window. 2 makes everything twice as big.
+// Must be above 0.
+void ezCameraZoom(float zoom);
+
+// Sets the camera's rotation about the centre of the window, anticlockwise in radians
+void ezCameraRotate(float radians);
+
+// Finds the point in the world shown at a point in the window, such as the mouse, through the current camera
+void ezScreenToWorld(double x, double y, double* worldX, double* worldY);
+
+// ===============
+// Scene Functions
+// ===============
+
+// The scene is an optional list of objects that stays on the GPU between frames, all drawn with one ezDrawScene call.
+// Only the objects moved, resized, recoloured or otherwise changed since the last ezDrawScene are sent to the GPU again,
+// so a mostly still scene costs little to draw however many objects are in it.
+
+// Adds an object to the end of the scene, so it's drawn over the objects already in it.
+// Does nothing if the object is already in the scene. Deleted objects leave the scene by themselves.
+void ezSceneAdd(EZobject* object);
+
+// Takes an object out of the scene, without deleting it
+void ezSceneRemove(EZobject* object);
+
+// Takes every object out of the scene
+void ezSceneClear(void);
+
+// Draws every object in the scene in the order they were added, over anything drawn so far this frame.
+// Objects in the scene can still be drawn with ezDraw as well.
+void ezDrawScene(void);
+
+// Gets statistics about the scene and the last time it was drawn
+void ezGetSceneStats(EZscenestats* stats);
+
+// =================
+// Picking Functions
+// =================
+
+// Picking finds the objects at a point in the window, such as the mouse (see ezSetMouseMoveFunction).
+// It goes by what was drawn in the last frame, with ezDraw, ezDrawMany or ezDrawScene: an object drawn later is on top,
+// rounded corners are left out, and objects deleted since are skipped. Each object is seen through the camera
+// it was drawn with. Only the objects near the point are checked.
+// Drawing is only recorded once the program has picked something, so picks find nothing until the frame after the first.
+
+// Gets the topmost object at a point in the window, or NULL if there's nothing there
+EZobject* ezPick(double x, double y);
+
+// Gets every object at a point in the window, topmost first. Stores up to max of them in objects,
+// and returns how many there are in all, which may be more than max.
+int ezPickAll(double x, double y, EZobject** objects, int max);
+
+// ==================
+// Profiler Functions
+// ==================
+
+// Gets timings of the last EZ_PROFILE_FRAMES frames (fewer at startup). See EZprofile.
+// Phases are timed on the CPU, so time spent waiting for the GPU shows up in EZ_PHASE_PRESENT.
+void ezGetProfile(EZprofile* profile);
+
+// Shows or hides a graph of recent frame times in the bottom left of the window, drawn over everything else.
+// Each bar is a frame, split into its phases: clear (grey), upload (purple), draw (green), submit (yellow),
+// present (red) and events (blue). The lines are at 60 and 30 frames per second.
+// Above it are the mean (white) and 99th percentile (red) frame times in milliseconds.
+// The overlay takes a little time to draw itself, which counts towards the draw phase.
+void ezSetProfilerOverlay(int enabled);
+
+// Starts timing the GPU work of everything drawn until the matching ezGpuScopeEnd. Scopes can be nested.
+// The name is kept rather than copied, so it must last until the results come back, e.g. a string literal.
+// Batches being collected are sent to the GPU at each end of a scope, so scopes around few objects cost extra draw calls.
+void ezGpuScopeBegin(const char* name);
+
+// Stops timing the innermost scope. Scopes still open at the end of the frame are ended automatically.
+void ezGpuScopeEnd(void);
+
+// Gets the GPU time taken by the most recent frame the GPU has finished, usually two or three frames ago.
+// Reading these never waits for the GPU. Each time is measured between points the GPU reached in the frame,
+// so any time it spent idle waiting for more work is included too.
+void ezGetGpuStats(EZgpustats* stats);
+
+// ===============
+// Trace Functions
+// ===============
+
+// Starts recording a trace to the given file, in the Chrome trace event format.
+// Open it in chrome://tracing or https://ui.perfetto.dev to see what each thread was doing over time.
+// Besides your own scopes, the trace shows each phase of every frame, batches, image loading and decoding,
+// and the GPU's times from ezGetGpuStats on a row of their own.
+// Any trace already being recorded is stopped first. Returns EZ_OK, or 0 if the file can't be opened.
+int ezTraceStart(const char* fileName);
+
+// Writes the rest of the trace and closes the file. Called automatically when the program exits.
+void ezTraceStop(void);
+
+// Writes everything recorded so far to the trace file.
+// This already happens whenever a thread has recorded a lot, so it's only needed to see the trace before it stops.
+void ezTraceFlush(void);
+
+// Marks the start of a scope in the trace. Can be called from any thread, and scopes can be nested.
+// Cheap enough to leave in: does nothing but a check when no trace is being recorded.
+// The name is kept rather than copied, so it must last until the trace is written, e.g. a string literal.
+void ezTraceBegin(const char* name);
+
+// Marks the end of the calling thread's innermost scope
+void ezTraceEnd(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
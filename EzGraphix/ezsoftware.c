@@ -0,0 +1,736 @@
+#include "ezsoftware.h"
+#include "ezthread.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// SSE2 is always there on x64. AVX2 has to be turned on when compiling (/arch:AVX2 or -mavx2).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EZ_SOFTWARE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// The colour buffer is split into square tiles of this many pixels, which are drawn in parallel
+#define EZ_SOFTWARE_TILE_SIZE 64
+// Max number of shapes queued before they're drawn
+#define EZ_SOFTWARE_QUEUE_CAPACITY 4096
+// Max number of threads drawing tiles, besides the one calling ezSoftwareFlush
+#define EZ_SOFTWARE_MAX_WORKERS 16
+
+struct EzSoftware {
+	// colour buffer, one RGBA pixel per element, bottom row first
+	uint32_t* pixels;
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	// shapes waiting to be drawn, in order
+	struct EzSoftwareShape* queue;
+	int count;
+	// the shapes touching each tile, as indices into the queue in draw order.
+	// Tile i's shapes are bins[binStarts[i]] up to bins[binStarts[i + 1]].
+	int* binStarts;
+	int* binEnds;
+	int* bins;
+	int binCapacity;
+	EzThread workers[EZ_SOFTWARE_MAX_WORKERS];
+	int workerCount;
+	EzMutex mutex;
+	// signalled when there are tiles to draw, or when the workers should stop
+	EzCond wake;
+	// signalled when the last tile is drawn
+	EzCond done;
+	// counts up every time there are tiles to draw
+	int job;
+	int nextTile;
+	int tilesLeft;
+	int shutdown;
+};
+
+static struct EzSoftware g_ezSoftware;
+
+// Packs a colour into the layout of the colour buffer, which is bytes in RGBA order whatever the endianness
+static uint32_t ezSoftwarePack(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a) {
+	const unsigned char bytes[4] = { r, g, b, a };
+	uint32_t pixel;
+	memcpy(&pixel, bytes, sizeof(pixel));
+	return pixel;
+}
+
+// Converts a colour channel to a byte the way OpenGL does when writing to an 8 bit buffer
+static unsigned char ezSoftwareChannel(const float value) {
+	if (value <= 0.0f) return 0;
+	if (value >= 1.0f) return 255;
+	return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+// Fills a run of pixels with one colour
+static void ezSoftwareFill(uint32_t* pixels, const int count, const uint32_t colour) {
+	int i = 0;
+
+#ifdef __AVX2__
+	const __m256i wide = _mm256_set1_epi32((int)colour);
+
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_si256((__m256i*)(pixels + i), wide);
+	}
+#endif
+
+#ifdef EZ_SOFTWARE_SSE2
+	const __m128i quad = _mm_set1_epi32((int)colour);
+
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_si128((__m128i*)(pixels + i), quad);
+	}
+#endif
+
+	for (; i < count; i++) {
+		pixels[i] = colour;
+	}
+}
+
+// Whether a shape has rounded corners or a border, which are drawn with blended edges
+static int ezSoftwareSoft(const struct EzSoftwareShape* shape) {
+	return shape->radii[0] > 0.0f || shape->radii[1] > 0.0f || shape->radii[2] > 0.0f || shape->radii[3] > 0.0f || shape->borderWidth > 0.0f;
+}
+
+// The biggest fillet radius of a shape, as drawn: no bigger than half the shorter side
+static float ezSoftwareMaxRadius(const struct EzSoftwareShape* shape) {
+	const float limit = (shape->width < shape->height ? shape->width : shape->height) * 0.5f;
+	float radius = 0.0f;
+
+	for (int i = 0; i < 4; i++) {
+		if (shape->radii[i] > radius) radius = shape->radii[i];
+	}
+
+	return radius < limit ? radius : limit;
+}
+
+// Whether a shape is turned or stretched
+static int ezSoftwareTransformed(const struct EzSoftwareShape* shape) {
+	const float* transform = shape->transform;
+	return transform[0] != 1.0f || transform[1] != 0.0f || transform[2] != 0.0f || transform[3] != 1.0f;
+}
+
+// Signed distance from a point, relative to the bottom left of a shape, to the shape's rounded edge. Negative inside.
+// This mirrors roundedBox in the fragment shader. Also gives the direction the distance grows in, as a unit vector.
+static float ezSoftwareDistance(const struct EzSoftwareShape* shape, const float x, const float y, float gradient[2]) {
+	const float halfWidth = shape->width * 0.5f;
+	const float halfHeight = shape->height * 0.5f;
+	const float px = x - halfWidth;
+	const float py = y - halfHeight;
+
+	// each quadrant uses its own corner's radius
+	float radius = px < 0.0f ? (py < 0.0f ? shape->radii[0] : shape->radii[3]) : (py < 0.0f ? shape->radii[1] : shape->radii[2]);
+	const float limit = halfWidth < halfHeight ? halfWidth : halfHeight;
+	if (radius > limit) radius = limit;
+
+	const float qx = fabsf(px) - halfWidth + radius;
+	const float qy = fabsf(py) - halfHeight + radius;
+
+	// around the corner
+	if (qx > 0.0f && qy > 0.0f) {
+		const float length = sqrtf(qx * qx + qy * qy);
+		gradient[0] = (px < 0.0f ? -qx : qx) / length;
+		gradient[1] = (py < 0.0f ? -qy : qy) / length;
+		return length - radius;
+	}
+
+	// along a straight edge, or inside
+	gradient[0] = qx > qy ? (px < 0.0f ? -1.0f : 1.0f) : 0.0f;
+	gradient[1] = qx > qy ? 0.0f : (py < 0.0f ? -1.0f : 1.0f);
+	return (qx > qy ? qx : qy) - radius;
+}
+
+// How much of a pixel is inside an edge, like coverage in the fragment shader
+static float ezSoftwareCoverage(const float distance, const float pixel) {
+	const float coverage = 0.5f - distance / pixel;
+	return coverage < 0.0f ? 0.0f : (coverage > 1.0f ? 1.0f : coverage);
+}
+
+// Blends a colour over a pixel, the way OpenGL does for the blend function soft edges are drawn with
+static uint32_t ezSoftwareBlend(const uint32_t pixel, const float r, const float g, const float b, const float alpha) {
+	unsigned char bytes[4];
+	memcpy(bytes, &pixel, sizeof(bytes));
+
+	const float keep = (1.0f - alpha) / 255.0f;
+	return ezSoftwarePack(
+		ezSoftwareChannel(r * alpha + bytes[0] * keep),
+		ezSoftwareChannel(g * alpha + bytes[1] * keep),
+		ezSoftwareChannel(b * alpha + bytes[2] * keep),
+		ezSoftwareChannel(alpha + bytes[3] * keep));
+}
+
+// A mipmap level of a shape's image
+struct EzSoftwareLevel {
+	const unsigned char* texels;
+	int width;
+	int height;
+};
+
+// Picks the mipmap level to draw a shape with, like GL_NEAREST_MIPMAP_NEAREST. The axes are the shape's own units
+// per pixel across the window, then up it. The transform is the same everywhere on the shape, so the level is too.
+static struct EzSoftwareLevel ezSoftwarePickLevel(const struct EzSoftwareShape* shape, const float axes[4]) {
+	struct EzSoftwareLevel level = { shape->texels, shape->textureWidth, shape->textureHeight };
+
+	// texels per pixel, along whichever axis of the window the image is squashed more
+	const float texelsX = (float)shape->textureWidth / shape->width;
+	const float texelsY = (float)shape->textureHeight / shape->height;
+	const float scaleX = sqrtf(texelsX * axes[0] * texelsX * axes[0] + texelsY * axes[1] * texelsY * axes[1]);
+	const float scaleY = sqrtf(texelsX * axes[2] * texelsX * axes[2] + texelsY * axes[3] * texelsY * axes[3]);
+	const float lod = log2f(scaleX > scaleY ? scaleX : scaleY);
+	int index = lod > 0.5f ? (int)ceilf(lod + 0.5f) - 1 : 0;
+
+	if (index > shape->textureLevels - 1) {
+		index = shape->textureLevels - 1;
+	}
+
+	for (int i = 0; i < index; i++) {
+		level.texels += (size_t)level.width * level.height * 4;
+		level.width = level.width > 1 ? level.width / 2 : 1;
+		level.height = level.height > 1 ? level.height / 2 : 1;
+	}
+
+	return level;
+}
+
+// Works out a shape's colour at a point relative to its bottom left. Returns 0 if the point is see-through.
+static int ezSoftwareShade(const struct EzSoftwareShape* shape, const struct EzSoftwareLevel* level, const float x, const float y, uint32_t* colour) {
+	// nearest texel, like the GL_NEAREST filter
+	int u = (int)(x / shape->width * (float)level->width);
+	int v = (int)(y / shape->height * (float)level->height);
+	if (u >= level->width) u = level->width - 1;
+	if (v >= level->height) v = level->height - 1;
+	if (u < 0) u = 0;
+	if (v < 0) v = 0;
+
+	const unsigned char* texel = level->texels + ((size_t)v * level->width + u) * 4;
+
+	if (texel[3] == 0) {
+		return 0;
+	}
+
+	*colour = ezSoftwarePack(
+		ezSoftwareChannel(texel[0] / 255.0f * shape->r),
+		ezSoftwareChannel(texel[1] / 255.0f * shape->g),
+		ezSoftwareChannel(texel[2] / 255.0f * shape->b),
+		texel[3]);
+	return 1;
+}
+
+// Draws a pixel of a shape with soft edges, at a point relative to its bottom left.
+// Blends in the shape's edge and border the same way as the fragment shader. The axes are as for ezSoftwarePickLevel.
+static void ezSoftwareSoftPixel(const struct EzSoftwareShape* shape, const struct EzSoftwareLevel* level, const float axes[4], const float x, const float y, uint32_t* pixel) {
+	float gradient[2];
+	const float distance = ezSoftwareDistance(shape, x, y, gradient);
+	// how much the distance changes from one pixel to the next, which the shader estimates with fwidth
+	const float step = fabsf(gradient[0] * axes[0] + gradient[1] * axes[1]) + fabsf(gradient[0] * axes[2] + gradient[1] * axes[3]);
+	float alpha = ezSoftwareCoverage(distance, step);
+	float inner = ezSoftwareCoverage(distance + shape->borderWidth, step);
+
+	if (alpha <= 0.0f) {
+		return;
+	}
+
+	float r = shape->r;
+	float g = shape->g;
+	float b = shape->b;
+
+	if (shape->texels) {
+		uint32_t colour;
+
+		if (ezSoftwareShade(shape, level, x, y, &colour)) {
+			unsigned char bytes[4];
+			memcpy(bytes, &colour, sizeof(bytes));
+			r = bytes[0] / 255.0f;
+			g = bytes[1] / 255.0f;
+			b = bytes[2] / 255.0f;
+		} else {
+			// see-through parts of the image still get the border drawn over them
+			if (inner >= 1.0f) return;
+			alpha *= 1.0f - inner;
+			inner = 0.0f;
+		}
+	}
+
+	*pixel = ezSoftwareBlend(*pixel,
+		shape->borderR + (r - shape->borderR) * inner,
+		shape->borderG + (g - shape->borderG) * inner,
+		shape->borderB + (b - shape->borderB) * inner,
+		alpha);
+}
+
+// Gets the pixels a shape covers, clipped to the colour buffer: x0 <= x < x1, y0 <= y < y1.
+// Like OpenGL, a pixel is covered if its centre is inside the shape. Soft edged shapes also cover the pixels
+// just outside, like the grown quad in the vertex shader. Returns 0 if it covers none.
+static int ezSoftwareBounds(const struct EzSoftwareShape* shape, int* x0, int* y0, int* x1, int* y1) {
+	const float grow = ezSoftwareSoft(shape) ? 1.0f : 0.0f;
+	float left = shape->x;
+	float bottom = shape->y;
+	float right = shape->x + shape->width;
+	float top = shape->y + shape->height;
+
+	// the box around the corners, wherever they've been turned to
+	if (ezSoftwareTransformed(shape)) {
+		const float* transform = shape->transform;
+		right = left;
+		top = bottom;
+
+		for (int i = 1; i < 4; i++) {
+			const float u = i == 1 || i == 2 ? shape->width : 0.0f;
+			const float v = i >= 2 ? shape->height : 0.0f;
+			const float x = shape->x + u * transform[0] + v * transform[2];
+			const float y = shape->y + u * transform[1] + v * transform[3];
+
+			if (x < left) left = x;
+			if (y < bottom) bottom = y;
+			if (x > right) right = x;
+			if (y > top) top = y;
+		}
+	}
+
+	*x0 = (int)ceilf(left - grow - 0.5f);
+	*y0 = (int)ceilf(bottom - grow - 0.5f);
+	*x1 = (int)ceilf(right + grow - 0.5f);
+	*y1 = (int)ceilf(top + grow - 0.5f);
+
+	if (*x0 < 0) *x0 = 0;
+	if (*y0 < 0) *y0 = 0;
+	if (*x1 > g_ezSoftware.width) *x1 = g_ezSoftware.width;
+	if (*y1 > g_ezSoftware.height) *y1 = g_ezSoftware.height;
+
+	return *x0 < *x1 && *y0 < *y1;
+}
+
+// Draws the part of a turned or stretched shape inside a rectangle of the colour buffer: x0 <= x < x1, y0 <= y < y1.
+// Each pixel is mapped back into the shape's own units, where the shape is upright again.
+static void ezSoftwareDrawTransformed(const struct EzSoftwareShape* shape, const int x0, const int y0, const int x1, const int y1) {
+	const float* transform = shape->transform;
+	const float determinant = transform[0] * transform[3] - transform[1] * transform[2];
+
+	// squashed flat, so it covers nothing
+	if (determinant == 0.0f) {
+		return;
+	}
+
+	// the shape's own units per pixel across the window, then up it
+	const float axes[4] = { transform[3] / determinant, -transform[1] / determinant, -transform[2] / determinant, transform[0] / determinant };
+	const uint32_t flat = ezSoftwarePack(ezSoftwareChannel(shape->r), ezSoftwareChannel(shape->g), ezSoftwareChannel(shape->b), 255);
+	const struct EzSoftwareLevel level = shape->texels ? ezSoftwarePickLevel(shape, axes) : (struct EzSoftwareLevel){ NULL, 0, 0 };
+	const int soft = ezSoftwareSoft(shape);
+
+	// points this far inside every edge are clear of the corners, the border and the blended edge, as in ezSoftwareDrawShape
+	const float margin = soft ? ezSoftwareMaxRadius(shape) + shape->borderWidth
+		+ sqrtf(axes[0] * axes[0] + axes[1] * axes[1]) + sqrtf(axes[2] * axes[2] + axes[3] * axes[3]) : 0.0f;
+
+	for (int y = y0; y < y1; y++) {
+		uint32_t* row = g_ezSoftware.pixels + (size_t)y * g_ezSoftware.width;
+		const float dy = (float)y + 0.5f - shape->y;
+		const float rowU = dy * axes[2];
+		const float rowV = dy * axes[3];
+
+		for (int x = x0; x < x1; x++) {
+			const float dx = (float)x + 0.5f - shape->x;
+			const float u = dx * axes[0] + rowU;
+			const float v = dx * axes[1] + rowV;
+
+			if (!soft) {
+				// like OpenGL, a pixel is covered if its centre is inside the shape
+				if (u < 0.0f || v < 0.0f || u >= shape->width || v >= shape->height) continue;
+			} else if (u < margin || v < margin || u > shape->width - margin || v > shape->height - margin) {
+				ezSoftwareSoftPixel(shape, &level, axes, u, v, row + x);
+				continue;
+			}
+
+			uint32_t colour = flat;
+
+			if (shape->texels == NULL || ezSoftwareShade(shape, &level, u, v, &colour)) {
+				row[x] = colour;
+			}
+		}
+	}
+}
+
+// Draws the part of a shape inside a rectangle of the colour buffer
+static void ezSoftwareDrawShape(const struct EzSoftwareShape* shape, const int left, const int bottom, const int right, const int top) {
+	// one pixel is one unit of the shape, along the same axes
+	static const float upright[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+	int x0, y0, x1, y1;
+
+	if (!ezSoftwareBounds(shape, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+
+	if (x0 < left) x0 = left;
+	if (y0 < bottom) y0 = bottom;
+	if (x1 > right) x1 = right;
+	if (y1 > top) y1 = top;
+
+	if (ezSoftwareTransformed(shape)) {
+		ezSoftwareDrawTransformed(shape, x0, y0, x1, y1);
+		return;
+	}
+
+	const uint32_t flat = ezSoftwarePack(ezSoftwareChannel(shape->r), ezSoftwareChannel(shape->g), ezSoftwareChannel(shape->b), 255);
+	const struct EzSoftwareLevel level = shape->texels ? ezSoftwarePickLevel(shape, upright) : (struct EzSoftwareLevel){ NULL, 0, 0 };
+
+	// pixels whose centres are this far inside every edge are clear of the corners, the border and the blended edge,
+	// so they're drawn without working out the distance to the edge. Sharp shapes are like that all over.
+	const float margin = ezSoftwareSoft(shape) ? ezSoftwareMaxRadius(shape) + shape->borderWidth + 1.0f : 0.0f;
+	int innerX0 = (int)ceilf(shape->x + margin - 0.5f);
+	int innerY0 = (int)ceilf(shape->y + margin - 0.5f);
+	int innerX1 = (int)ceilf(shape->x + shape->width - margin - 0.5f);
+	int innerY1 = (int)ceilf(shape->y + shape->height - margin - 0.5f);
+	if (innerX0 < x0) innerX0 = x0;
+	if (innerY0 < y0) innerY0 = y0;
+	if (innerX1 > x1) innerX1 = x1;
+	if (innerY1 > y1) innerY1 = y1;
+	if (innerX1 < innerX0) innerX1 = innerX0;
+
+	for (int y = y0; y < y1; y++) {
+		uint32_t* row = g_ezSoftware.pixels + (size_t)y * g_ezSoftware.width;
+		const float localY = (float)y + 0.5f - shape->y;
+		const int inside = y >= innerY0 && y < innerY1;
+		const int spanStart = inside ? innerX0 : x0;
+		const int spanEnd = inside ? innerX1 : x0;
+
+		// the edges: blend pixel by pixel
+		for (int x = x0; x < x1; x++) {
+			if (x == spanStart) x = spanEnd;
+			if (x >= x1) break;
+
+			ezSoftwareSoftPixel(shape, &level, upright, (float)x + 0.5f - shape->x, localY, row + x);
+		}
+
+		// everything in between
+		if (shape->texels == NULL) {
+			ezSoftwareFill(row + spanStart, spanEnd - spanStart, flat);
+		} else {
+			for (int x = spanStart; x < spanEnd; x++) {
+				uint32_t colour;
+
+				if (ezSoftwareShade(shape, &level, (float)x + 0.5f - shape->x, localY, &colour)) {
+					row[x] = colour;
+				}
+			}
+		}
+	}
+}
+
+// Draws every shape binned into a tile
+static void ezSoftwareDrawTile(const int tile) {
+	const int left = (tile % g_ezSoftware.tilesX) * EZ_SOFTWARE_TILE_SIZE;
+	const int bottom = (tile / g_ezSoftware.tilesX) * EZ_SOFTWARE_TILE_SIZE;
+	const int right = left + EZ_SOFTWARE_TILE_SIZE < g_ezSoftware.width ? left + EZ_SOFTWARE_TILE_SIZE : g_ezSoftware.width;
+	const int top = bottom + EZ_SOFTWARE_TILE_SIZE < g_ezSoftware.height ? bottom + EZ_SOFTWARE_TILE_SIZE : g_ezSoftware.height;
+
+	for (int i = g_ezSoftware.binStarts[tile]; i < g_ezSoftware.binStarts[tile + 1]; i++) {
+		ezSoftwareDrawShape(&(g_ezSoftware.queue[g_ezSoftware.bins[i]]), left, bottom, right, top);
+	}
+}
+
+// Takes tiles from the current job and draws them until there are none left
+static void ezSoftwareDrawTiles(void) {
+	for (;;) {
+		ezMutexLock(&(g_ezSoftware.mutex));
+		const int tile = g_ezSoftware.nextTile < g_ezSoftware.tilesX * g_ezSoftware.tilesY ? g_ezSoftware.nextTile++ : -1;
+		ezMutexUnlock(&(g_ezSoftware.mutex));
+
+		if (tile < 0) {
+			return;
+		}
+
+		ezSoftwareDrawTile(tile);
+
+		ezMutexLock(&(g_ezSoftware.mutex));
+
+		if (--g_ezSoftware.tilesLeft == 0) {
+			ezCondBroadcast(&(g_ezSoftware.done));
+		}
+
+		ezMutexUnlock(&(g_ezSoftware.mutex));
+	}
+}
+
+// Worker thread: helps draw tiles whenever there's a job, until told to stop
+static EZ_THREAD_PROC(ezSoftwareWorker) {
+	int job = 0;
+	(void)arg;
+
+	ezMutexLock(&(g_ezSoftware.mutex));
+
+	for (;;) {
+		while (g_ezSoftware.job == job && !g_ezSoftware.shutdown) {
+			ezCondWait(&(g_ezSoftware.wake), &(g_ezSoftware.mutex));
+		}
+
+		if (g_ezSoftware.shutdown) {
+			break;
+		}
+
+		job = g_ezSoftware.job;
+
+		ezMutexUnlock(&(g_ezSoftware.mutex));
+		ezSoftwareDrawTiles();
+		ezMutexLock(&(g_ezSoftware.mutex));
+	}
+
+	ezMutexUnlock(&(g_ezSoftware.mutex));
+	EZ_THREAD_RETURN;
+}
+
+int ezSoftwareInit(void) {
+	g_ezSoftware.queue = malloc(sizeof(struct EzSoftwareShape) * EZ_SOFTWARE_QUEUE_CAPACITY);
+
+	if (g_ezSoftware.queue == NULL) {
+		return 0;
+	}
+
+	ezMutexInit(&(g_ezSoftware.mutex));
+	ezCondInit(&(g_ezSoftware.wake));
+	ezCondInit(&(g_ezSoftware.done));
+
+	// the thread calling ezSoftwareFlush draws tiles too
+	int workers = ezProcessorCount() - 1;
+
+	if (workers > EZ_SOFTWARE_MAX_WORKERS) {
+		workers = EZ_SOFTWARE_MAX_WORKERS;
+	}
+
+	while (g_ezSoftware.workerCount < workers && ezThreadStart(&(g_ezSoftware.workers[g_ezSoftware.workerCount]), ezSoftwareWorker, NULL)) {
+		g_ezSoftware.workerCount++;
+	}
+
+	return 1;
+}
+
+void ezSoftwareFree(void) {
+	if (g_ezSoftware.queue == NULL) {
+		return;
+	}
+
+	ezMutexLock(&(g_ezSoftware.mutex));
+	g_ezSoftware.shutdown = 1;
+	ezCondBroadcast(&(g_ezSoftware.wake));
+	ezMutexUnlock(&(g_ezSoftware.mutex));
+
+	for (int i = 0; i < g_ezSoftware.workerCount; i++) {
+		ezThreadJoin(g_ezSoftware.workers[i]);
+	}
+
+	ezCondDestroy(&(g_ezSoftware.done));
+	ezCondDestroy(&(g_ezSoftware.wake));
+	ezMutexDestroy(&(g_ezSoftware.mutex));
+
+	free(g_ezSoftware.pixels);
+	free(g_ezSoftware.queue);
+	free(g_ezSoftware.binStarts);
+	free(g_ezSoftware.binEnds);
+	free(g_ezSoftware.bins);
+	memset(&g_ezSoftware, 0, sizeof(struct EzSoftware));
+}
+
+int ezSoftwareResize(const int width, const int height) {
+	const int tilesX = (width + EZ_SOFTWARE_TILE_SIZE - 1) / EZ_SOFTWARE_TILE_SIZE;
+	const int tilesY = (height + EZ_SOFTWARE_TILE_SIZE - 1) / EZ_SOFTWARE_TILE_SIZE;
+	uint32_t* pixels = malloc(sizeof(uint32_t) * ((size_t)width * height + 1));
+	int* binStarts = malloc(sizeof(int) * (tilesX * tilesY + 1));
+	int* binEnds = malloc(sizeof(int) * (tilesX * tilesY + 1));
+
+	if (pixels == NULL || binStarts == NULL || binEnds == NULL) {
+		free(pixels);
+		free(binStarts);
+		free(binEnds);
+		return 0;
+	}
+
+	free(g_ezSoftware.pixels);
+	free(g_ezSoftware.binStarts);
+	free(g_ezSoftware.binEnds);
+	g_ezSoftware.pixels = pixels;
+	g_ezSoftware.binStarts = binStarts;
+	g_ezSoftware.binEnds = binEnds;
+	g_ezSoftware.width = width;
+	g_ezSoftware.height = height;
+
+	// idle workers still look at the tile count
+	ezMutexLock(&(g_ezSoftware.mutex));
+	g_ezSoftware.tilesX = tilesX;
+	g_ezSoftware.tilesY = tilesY;
+	ezMutexUnlock(&(g_ezSoftware.mutex));
+
+	ezSoftwareFill(pixels, width * height, ezSoftwarePack(0, 0, 0, 255));
+	return 1;
+}
+
+void ezSoftwareClear(const float r, const float g, const float b) {
+	const uint32_t colour = ezSoftwarePack(ezSoftwareChannel(r), ezSoftwareChannel(g), ezSoftwareChannel(b), 255);
+
+	g_ezSoftware.count = 0;
+	ezSoftwareFill(g_ezSoftware.pixels, g_ezSoftware.width * g_ezSoftware.height, colour);
+}
+
+void ezSoftwareAdd(const struct EzSoftwareShape* shape) {
+	if (g_ezSoftware.count == EZ_SOFTWARE_QUEUE_CAPACITY) {
+		ezSoftwareFlush();
+	}
+
+	g_ezSoftware.queue[g_ezSoftware.count++] = *shape;
+}
+
+// Sorts the queued shapes into the tiles they touch, keeping them in order. Returns 0 if there's no memory for it.
+static int ezSoftwareBin(void) {
+	const int tiles = g_ezSoftware.tilesX * g_ezSoftware.tilesY;
+	int* starts = g_ezSoftware.binStarts;
+	int* ends = g_ezSoftware.binEnds;
+
+	// count the shapes in each tile...
+	memset(starts, 0, sizeof(int) * (tiles + 1));
+
+	for (int i = 0; i < g_ezSoftware.count; i++) {
+		int x0, y0, x1, y1;
+		if (!ezSoftwareBounds(&(g_ezSoftware.queue[i]), &x0, &y0, &x1, &y1)) continue;
+
+		for (int ty = y0 / EZ_SOFTWARE_TILE_SIZE; ty <= (y1 - 1) / EZ_SOFTWARE_TILE_SIZE; ty++) {
+			for (int tx = x0 / EZ_SOFTWARE_TILE_SIZE; tx <= (x1 - 1) / EZ_SOFTWARE_TILE_SIZE; tx++) {
+				starts[ty * g_ezSoftware.tilesX + tx + 1]++;
+			}
+		}
+	}
+
+	// ...work out where each tile's list starts...
+	for (int i = 0; i < tiles; i++) {
+		starts[i + 1] += starts[i];
+	}
+
+	const int total = starts[tiles];
+
+	if (total > g_ezSoftware.binCapacity) {
+		int* bins = realloc(g_ezSoftware.bins, sizeof(int) * total);
+		if (bins == NULL) return 0;
+
+		g_ezSoftware.bins = bins;
+		g_ezSoftware.binCapacity = total;
+	}
+
+	// ...then fill the lists
+	memcpy(ends, starts, sizeof(int) * tiles);
+
+	for (int i = 0; i < g_ezSoftware.count; i++) {
+		int x0, y0, x1, y1;
+		if (!ezSoftwareBounds(&(g_ezSoftware.queue[i]), &x0, &y0, &x1, &y1)) continue;
+
+		for (int ty = y0 / EZ_SOFTWARE_TILE_SIZE; ty <= (y1 - 1) / EZ_SOFTWARE_TILE_SIZE; ty++) {
+			for (int tx = x0 / EZ_SOFTWARE_TILE_SIZE; tx <= (x1 - 1) / EZ_SOFTWARE_TILE_SIZE; tx++) {
+				g_ezSoftware.bins[ends[ty * g_ezSoftware.tilesX + tx]++] = i;
+			}
+		}
+	}
+
+	return 1;
+}
+
+void ezSoftwareFlush(void) {
+	if (g_ezSoftware.count == 0) {
+		return;
+	}
+
+	if (!ezSoftwareBin()) {
+		// no memory to bin, so draw everything in one go on this thread
+		for (int i = 0; i < g_ezSoftware.count; i++) {
+			ezSoftwareDrawShape(&(g_ezSoftware.queue[i]), 0, 0, g_ezSoftware.width, g_ezSoftware.height);
+		}
+
+		g_ezSoftware.count = 0;
+		return;
+	}
+
+	ezMutexLock(&(g_ezSoftware.mutex));
+	g_ezSoftware.nextTile = 0;
+	g_ezSoftware.tilesLeft = g_ezSoftware.tilesX * g_ezSoftware.tilesY;
+	g_ezSoftware.job++;
+	ezCondBroadcast(&(g_ezSoftware.wake));
+	ezMutexUnlock(&(g_ezSoftware.mutex));
+
+	ezSoftwareDrawTiles();
+
+	// wait for the workers to finish their last tiles
+	ezMutexLock(&(g_ezSoftware.mutex));
+
+	while (g_ezSoftware.tilesLeft > 0) {
+		ezCondWait(&(g_ezSoftware.done), &(g_ezSoftware.mutex));
+	}
+
+	ezMutexUnlock(&(g_ezSoftware.mutex));
+	g_ezSoftware.count = 0;
+}
+
+unsigned char* ezSoftwareMipmaps(const unsigned char* pixels, const int width, const int height, const int maxLevel, int* levels) {
+	// work out the size of the whole chain first
+	size_t size = 0;
+	int count = 0;
+
+	for (int w = width, h = height; count <= maxLevel; count++) {
+		size += (size_t)w * h * 4;
+
+		if (w == 1 && h == 1) {
+			count++;
+			break;
+		}
+
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+
+	unsigned char* chain = malloc(size);
+
+	if (chain == NULL) {
+		return NULL;
+	}
+
+	memcpy(chain, pixels, (size_t)width * height * 4);
+
+	// each level averages 2x2 blocks of the one before. Odd rows and columns at the edge are left out.
+	const unsigned char* source = chain;
+	int sourceWidth = width;
+	int sourceHeight = height;
+
+	for (int i = 1; i < count; i++) {
+		unsigned char* target = (unsigned char*)source + (size_t)sourceWidth * sourceHeight * 4;
+		const int targetWidth = sourceWidth > 1 ? sourceWidth / 2 : 1;
+		const int targetHeight = sourceHeight > 1 ? sourceHeight / 2 : 1;
+
+		for (int y = 0; y < targetHeight; y++) {
+			const int y0 = y * 2 < sourceHeight ? y * 2 : sourceHeight - 1;
+			const int y1 = y * 2 + 1 < sourceHeight ? y * 2 + 1 : sourceHeight - 1;
+
+			for (int x = 0; x < targetWidth; x++) {
+				const int x0 = x * 2 < sourceWidth ? x * 2 : sourceWidth - 1;
+				const int x1 = x * 2 + 1 < sourceWidth ? x * 2 + 1 : sourceWidth - 1;
+
+				for (int c = 0; c < 4; c++) {
+					const int sum = source[((size_t)y0 * sourceWidth + x0) * 4 + c] + source[((size_t)y0 * sourceWidth + x1) * 4 + c]
+						+ source[((size_t)y1 * sourceWidth + x0) * 4 + c] + source[((size_t)y1 * sourceWidth + x1) * 4 + c];
+					target[((size_t)y * targetWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		source = target;
+		sourceWidth = targetWidth;
+		sourceHeight = targetHeight;
+	}
+
+	*levels = count;
+	return chain;
+}
+
+const unsigned char* ezSoftwarePixels(void) {
+	return (const unsigned char*)g_ezSoftware.pixels;
+}
@@ -0,0 +1,64 @@
+//
+// Internal software rasterizer for EzGraphix.
+// Draws the same shapes as the OpenGL shaders in ezgraphix.c entirely on the CPU, into a colour buffer in memory.
+// Useful where there's no GPU, and as a reference to compare the shaders against.
+// Not part of the public API.
+//
+// Author: Mekal Covic
+//
+
+#pragma once
+
+// A shape to draw, in window coordinates. If it's transformed, its sizes are in its own units instead, before the transform.
+struct EzSoftwareShape {
+	// bottom left corner
+	float x;
+	float y;
+	float width;
+	float height;
+	float r;
+	float g;
+	float b;
+	// fillet radius of each corner: bottom left, bottom right, top right, top left
+	float radii[4];
+	// border drawn inside the edge, or 0 for none
+	float borderWidth;
+	float borderR;
+	float borderG;
+	float borderB;
+	// RGBA image stretched over the shape, bottom row first, or NULL to draw it in plain colour.
+	// Followed by its mipmaps, from ezSoftwareMipmaps.
+	const unsigned char* texels;
+	int textureWidth;
+	int textureHeight;
+	int textureLevels;
+	// turns and stretches the shape about its bottom left corner: the point u across and v up from the corner is drawn at
+	// x + u * transform[0] + v * transform[2], y + u * transform[1] + v * transform[3]. 1, 0, 0, 1 for neither.
+	float transform[4];
+};
+
+// Copies an RGBA image and adds up to maxLevel mipmaps, each half the size of the one before.
+// Stores the number of levels made, including the image itself, in levels. Returns NULL if there's no memory for it.
+unsigned char* ezSoftwareMipmaps(const unsigned char* pixels, int width, int height, int maxLevel, int* levels);
+
+// Starts the worker threads and allocates the shape queue. Returns 0 if there's no memory for it.
+int ezSoftwareInit(void);
+
+// Stops the worker threads and frees all memory used by the rasterizer
+void ezSoftwareFree(void);
+
+// Sets the size of the colour buffer, which starts out black. Shapes already queued are kept.
+// Returns 0 if there's no memory for it, in which case the old buffer is kept.
+int ezSoftwareResize(int width, int height);
+
+// Fills the colour buffer with a colour, dropping anything queued
+void ezSoftwareClear(float r, float g, float b);
+
+// Queues a shape to be drawn on top of everything before it. Draws the queue first if it's full.
+void ezSoftwareAdd(const struct EzSoftwareShape* shape);
+
+// Draws every queued shape into the colour buffer
+void ezSoftwareFlush(void);
+
+// The colour buffer: RGBA, bottom row first. Only up to date after ezSoftwareFlush.
+const unsigned char* ezSoftwarePixels(void);
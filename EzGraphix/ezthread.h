@@ -0,0 +1,180 @@
+//
+// Internal threading helpers for EzGraphix.
+// A thin wrapper over the platform's threads, mutexes and condition variables,
+// so the rest of the library doesn't have to care which platform it's on.
+// Not part of the public API.
+//
+// Author: Mekal Covic
+//
+
+#pragma once
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+typedef HANDLE EzThread;
+typedef CRITICAL_SECTION EzMutex;
+typedef CONDITION_VARIABLE EzCond;
+// A value shared between threads without a lock, through ezAtomicLoad and ezAtomicStore
+typedef volatile LONG EzAtomic;
+
+// Declares a variable with a separate copy for each thread
+#define EZ_THREAD_LOCAL __declspec(thread)
+
+// Declares a function that can be run on a thread with ezThreadStart
+#define EZ_THREAD_PROC(name) DWORD WINAPI name(LPVOID arg)
+#define EZ_THREAD_RETURN return 0
+
+typedef DWORD (WINAPI* EzThreadProc)(LPVOID arg);
+
+// Starts a thread. Returns 0 if the thread could not be created.
+static inline int ezThreadStart(EzThread* thread, EzThreadProc proc, void* arg) {
+	*thread = CreateThread(NULL, 0, proc, arg, 0, NULL);
+	return *thread != NULL;
+}
+
+// Waits for a thread to finish and releases it
+static inline void ezThreadJoin(EzThread thread) {
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+static inline void ezMutexInit(EzMutex* mutex) {
+	InitializeCriticalSection(mutex);
+}
+
+static inline void ezMutexDestroy(EzMutex* mutex) {
+	DeleteCriticalSection(mutex);
+}
+
+static inline void ezMutexLock(EzMutex* mutex) {
+	EnterCriticalSection(mutex);
+}
+
+static inline void ezMutexUnlock(EzMutex* mutex) {
+	LeaveCriticalSection(mutex);
+}
+
+static inline void ezCondInit(EzCond* cond) {
+	InitializeConditionVariable(cond);
+}
+
+static inline void ezCondDestroy(EzCond* cond) {
+	// nothing to release on windows
+	(void)cond;
+}
+
+// Releases the mutex, waits to be woken, then takes the mutex again
+static inline void ezCondWait(EzCond* cond, EzMutex* mutex) {
+	SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+static inline void ezCondSignal(EzCond* cond) {
+	WakeConditionVariable(cond);
+}
+
+static inline void ezCondBroadcast(EzCond* cond) {
+	WakeAllConditionVariable(cond);
+}
+
+// Reads a value, seeing everything written before it was stored
+static inline long ezAtomicLoad(EzAtomic* atomic) {
+	return InterlockedCompareExchange(atomic, 0, 0);
+}
+
+// Stores a value once everything written before it is visible to other threads
+static inline void ezAtomicStore(EzAtomic* atomic, const long value) {
+	InterlockedExchange(atomic, value);
+}
+
+// Number of logical processors, for sizing thread pools
+static inline int ezProcessorCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+}
+
+#else
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t EzThread;
+typedef pthread_mutex_t EzMutex;
+typedef pthread_cond_t EzCond;
+// A value shared between threads without a lock, through ezAtomicLoad and ezAtomicStore
+typedef volatile long EzAtomic;
+
+// Declares a variable with a separate copy for each thread
+#define EZ_THREAD_LOCAL _Thread_local
+
+// Declares a function that can be run on a thread with ezThreadStart
+#define EZ_THREAD_PROC(name) void* name(void* arg)
+#define EZ_THREAD_RETURN return NULL
+
+typedef void* (*EzThreadProc)(void* arg);
+
+// Starts a thread. Returns 0 if the thread could not be created.
+static inline int ezThreadStart(EzThread* thread, EzThreadProc proc, void* arg) {
+	return pthread_create(thread, NULL, proc, arg) == 0;
+}
+
+// Waits for a thread to finish and releases it
+static inline void ezThreadJoin(EzThread thread) {
+	pthread_join(thread, NULL);
+}
+
+static inline void ezMutexInit(EzMutex* mutex) {
+	pthread_mutex_init(mutex, NULL);
+}
+
+static inline void ezMutexDestroy(EzMutex* mutex) {
+	pthread_mutex_destroy(mutex);
+}
+
+static inline void ezMutexLock(EzMutex* mutex) {
+	pthread_mutex_lock(mutex);
+}
+
+static inline void ezMutexUnlock(EzMutex* mutex) {
+	pthread_mutex_unlock(mutex);
+}
+
+static inline void ezCondInit(EzCond* cond) {
+	pthread_cond_init(cond, NULL);
+}
+
+static inline void ezCondDestroy(EzCond* cond) {
+	pthread_cond_destroy(cond);
+}
+
+// Releases the mutex, waits to be woken, then takes the mutex again
+static inline void ezCondWait(EzCond* cond, EzMutex* mutex) {
+	pthread_cond_wait(cond, mutex);
+}
+
+static inline void ezCondSignal(EzCond* cond) {
+	pthread_cond_signal(cond);
+}
+
+static inline void ezCondBroadcast(EzCond* cond) {
+	pthread_cond_broadcast(cond);
+}
+
+// Reads a value, seeing everything written before it was stored
+static inline long ezAtomicLoad(EzAtomic* atomic) {
+	return __atomic_load_n(atomic, __ATOMIC_ACQUIRE);
+}
+
+// Stores a value once everything written before it is visible to other threads
+static inline void ezAtomicStore(EzAtomic* atomic, const long value) {
+	__atomic_store_n(atomic, value, __ATOMIC_RELEASE);
+}
+
+// Number of logical processors, for sizing thread pools
+static inline int ezProcessorCount(void) {
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+#endif
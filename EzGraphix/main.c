@@ -5,6 +5,7 @@
 #include "ezgraphix.h"
 #include "ezmaths.h"
 #include <math.h>
+#include <stdio.h>
 
 #define PI 3.141592f
 
@@ -29,6 +30,11 @@ void mouseMove(double mouseX, double mouseY)
 	printf("Move %lf %lf\n", mouseX, mouseY);
 }
 
+void glError(int severity, const char* message, const char* callSite)
+{
+	printf("OpenGL error (severity %d) in %s: %s\n", severity, callSite ? callSite : "unknown", message);
+}
+
 void resize(int width, int height)
 {
 	ezMove(object, width / 3, 3 * height / 8);
@@ -49,6 +55,7 @@ int setup(void)
 	ezSetClickFunction(click);
 	ezSetMouseMoveFunction(mouseMove);
 	ezSetResizeFunction(resize);
+	ezSetOpenGLErrorFunction(glError);
 
 	// create first object
 	object = ezCreateRect(width / 3, height / 4);
@@ -66,13 +73,6 @@ int setup(void)
 	printf("Image ID: %d\n", image);
 	ezTexture(randomCircle, image);
 
-	// Test for errors
-	int error = ezGetOpenGLError();
-
-	if (error) {
-		printf("OpenGL error on setup: %d\n", error);
-	}
-
 	// Setup went ok. Proceed with running the program!
 	return EZ_OK;
 }
@@ -100,13 +100,6 @@ void draw(void)
 	if (time >= 2 * PI) {
 		time = 0;
 	}
-
-	// Test for errors
-	int error = ezGetOpenGLError();
-
-	if (error) {
-		printf("OpenGL error on draw: %d\n", error);
-	}
 }
 
 void cleanup(void)
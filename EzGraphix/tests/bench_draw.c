@@ -0,0 +1,98 @@
+//
+// Benchmark of the CPU time each ezDraw call takes, with uniform locations cached and without.
+// Draws the same objects every frame and times just the calls. The first pass times ezDraw as it is, the second
+// adds the six glGetUniformLocation lookups by name that ezDraw made for every object before the locations were
+// cached, so the two numbers are the time per call after and before.
+// The objects are just outside the window with culling off, so they go all the way through the batches
+// but the GPU clips them straight away: on a software GL driver, drawing them would be timed along with the calls.
+// Turning culling off needs ezSetCulling, so the benchmark only builds on trees that have it.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 480
+#define BENCH_OBJECTS 20000
+// frames to draw before timing each pass, while shaders and buffers are still being set up
+#define BENCH_WARMUP_FRAMES 10
+#define BENCH_FRAMES 100
+#define BENCH_PASSES 2
+
+EZobject* objects[BENCH_OBJECTS];
+int frame;
+double passTimes[BENCH_PASSES];
+
+// the uniforms ezDraw used to look up by name for every object. Most of them are instance attributes now,
+// so the lookups don't find them, but the driver still has to search its names for each one.
+static const char* uniformNames[] = {
+	"colour",
+	"position",
+	"dimensions",
+	"filletRadius",
+	"hasTexture",
+	"textureSampler",
+};
+
+static const char* passNames[BENCH_PASSES] = {
+	"cached locations",
+	"looked up by name",
+};
+
+int setup(void)
+{
+	ezDisplaySize(BENCH_WIDTH, BENCH_HEIGHT);
+	ezSetCulling(0);
+	srand(1);
+
+	for (int i = 0; i < BENCH_OBJECTS; i++) {
+		objects[i] = ezCreateRect(2.0f + rand() % 8, 2.0f + rand() % 8);
+		ezMove(objects[i], rand() % BENCH_WIDTH, -20.0);
+		ezColour(objects[i], (rand() % 256) / 255.0f, (rand() % 256) / 255.0f, (rand() % 256) / 255.0f);
+	}
+
+	return EZ_OK;
+}
+
+void draw(void)
+{
+	const int framesPerPass = BENCH_WARMUP_FRAMES + BENCH_FRAMES;
+	const int pass = frame / framesPerPass;
+	const int passFrame = frame % framesPerPass;
+	// the shader stays in use between frames, so this is the one the lookups went to
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+	const double start = ezTestTime();
+
+	for (int i = 0; i < BENCH_OBJECTS; i++) {
+		ezDraw(objects[i]);
+
+		if (pass == 1) {
+			for (int name = 0; name < (int)(sizeof(uniformNames) / sizeof(uniformNames[0])); name++) {
+				glGetUniformLocation(program, uniformNames[name]);
+			}
+		}
+	}
+
+	if (passFrame >= BENCH_WARMUP_FRAMES) {
+		passTimes[pass] += ezTestTime() - start;
+	}
+
+	if (passFrame == framesPerPass - 1) {
+		const double calls = (double)BENCH_OBJECTS * BENCH_FRAMES;
+		printf("ezDraw, %s: %.1f ns per call, %.2f ms per frame of %d objects\n",
+			passNames[pass], passTimes[pass] / calls * 1e9, passTimes[pass] / BENCH_FRAMES * 1e3, BENCH_OBJECTS);
+
+		if (pass == 1) {
+			printf("caching saves %.1f ns per call\n", (passTimes[1] - passTimes[0]) / calls * 1e9);
+			ezSetShouldClose();
+		}
+	}
+
+	frame++;
+}
+
+void cleanup(void)
+{
+}
@@ -0,0 +1,93 @@
+//
+// Benchmark of how fast each shader variant fills pixels.
+// Draws layers of window sized objects, first plain, then textured, then rounded, then both,
+// and reports the pixels filled per second for each. The GPU is waited for at the end of each frame,
+// so the times are the time it took to draw them.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_LAYERS 20
+#define BENCH_VARIANTS 4
+// frames to draw before timing each variant, while its shader is built
+#define BENCH_WARMUP_FRAMES 3
+#define BENCH_FRAMES 10
+
+EZobject* layers[BENCH_LAYERS];
+int image;
+int frame;
+double start;
+
+static const char* variantNames[BENCH_VARIANTS] = {
+	"plain",
+	"textured",
+	"rounded",
+	"textured and rounded",
+};
+
+// Sets the layers up for a variant
+static void setVariant(const int variant)
+{
+	for (int i = 0; i < BENCH_LAYERS; i++) {
+		ezTexture(layers[i], variant & 1 ? image : 0);
+		ezFilletRadius(layers[i], variant & 2 ? 40.0f : 0.0f);
+	}
+}
+
+int setup(void)
+{
+	ezDisplaySize(BENCH_WIDTH, BENCH_HEIGHT);
+	image = ezLoadImage("maminonawa.png");
+
+	if (image == 0) {
+		printf("Couldn't load maminonawa.png. Run the benchmark from the EzGraphix folder.\n");
+		return 0;
+	}
+
+	for (int i = 0; i < BENCH_LAYERS; i++) {
+		layers[i] = ezCreateRect(BENCH_WIDTH, BENCH_HEIGHT);
+		ezColour(layers[i], (i % 3) / 2.0f, (i % 5) / 4.0f, (i % 7) / 6.0f);
+	}
+
+	return EZ_OK;
+}
+
+void draw(void)
+{
+	const int framesPerVariant = BENCH_WARMUP_FRAMES + BENCH_FRAMES;
+	const int variant = frame / framesPerVariant;
+	const int variantFrame = frame % framesPerVariant;
+
+	if (variantFrame == 0) {
+		setVariant(variant);
+	} else if (variantFrame == BENCH_WARMUP_FRAMES) {
+		start = ezTestTime();
+	}
+
+	for (int i = 0; i < BENCH_LAYERS; i++) {
+		ezDraw(layers[i]);
+	}
+
+	// a frame's objects are only drawn once it's over, so this waits for the frame before.
+	// The time covers the last warmup frame but not this one: still BENCH_FRAMES frames.
+	glFinish();
+
+	if (variantFrame == framesPerVariant - 1) {
+		const double seconds = ezTestTime() - start;
+		const double pixels = (double)BENCH_WIDTH * BENCH_HEIGHT * BENCH_LAYERS * BENCH_FRAMES;
+		printf("%s: %.2f ms per frame, %.0f megapixels per second\n", variantNames[variant], seconds / BENCH_FRAMES * 1e3, pixels / seconds / 1e6);
+
+		if (variant == BENCH_VARIANTS - 1) {
+			ezSetShouldClose();
+		}
+	}
+
+	frame++;
+}
+
+void cleanup(void)
+{
+}
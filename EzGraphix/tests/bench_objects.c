@@ -0,0 +1,52 @@
+//
+// Benchmark of creating, resizing and deleting many objects.
+// Every object is an instance of the same unit quad, so none of these should touch the GPU.
+// The second round reuses the slots the first one freed.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define BENCH_OBJECTS 100000
+#define BENCH_ROUNDS 2
+
+EZobject* objects[BENCH_OBJECTS];
+
+int setup(void)
+{
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		const double start = ezTestTime();
+
+		for (int i = 0; i < BENCH_OBJECTS; i++) {
+			objects[i] = ezCreateRect(10.0f, 10.0f);
+		}
+
+		const double created = ezTestTime();
+
+		for (int i = 0; i < BENCH_OBJECTS; i++) {
+			ezResize(objects[i], 5.0f + i % 20, 5.0f + i % 30);
+		}
+
+		const double resized = ezTestTime();
+
+		for (int i = 0; i < BENCH_OBJECTS; i++) {
+			ezDelete(objects[i]);
+		}
+
+		const double deleted = ezTestTime();
+
+		printf("round %d, %d objects: create %.2f ms, resize %.2f ms, delete %.2f ms\n", round + 1, BENCH_OBJECTS,
+			(created - start) * 1e3, (resized - created) * 1e3, (deleted - resized) * 1e3);
+	}
+
+	ezSetShouldClose();
+	return EZ_OK;
+}
+
+void draw(void)
+{
+}
+
+void cleanup(void)
+{
+}
@@ -0,0 +1,87 @@
+//
+// Helpers shared by the EzGraphix tests and benchmarks.
+// Each one is a program of its own, with setup, draw and cleanup like any other, since the library owns main.
+// They're meant for headless builds (see ezgraphix.h), built from the EzGraphix folder and run from the same place:
+//   gcc -std=c11 -O2 -DEZ_HEADLESS -I. -I../libs/GLEW/include -I../libs/GLFW/include
+//       ezgraphix.c ezmaths.c ezsoftware.c tests/bench_draw.c -o bench_draw -lGLEW -lEGL -lGL -lpthread -lm
+//   ./bench_draw
+// Tests print each check, then PASS or FAIL, and exit with a matching status. Benchmarks print their timings.
+// Either one stops by itself, so run them without --frames.
+//
+// Author: Mekal Covic
+//
+
+#pragma once
+
+#ifndef _WIN32
+// for clock_gettime
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "ezgraphix.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int g_ezTestFailures;
+
+// Gets the time in seconds, from some fixed point in the past
+static inline double ezTestTime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// Prints the outcome of a check, counting it if it failed
+static inline void ezTestCheck(const int passed, const char* name) {
+	printf("%s: %s\n", passed ? "ok" : "FAILED", name);
+
+	if (!passed) {
+		g_ezTestFailures++;
+	}
+}
+
+// Gets the number of bytes that differ between two window readbacks (see ezReadPixels)
+static inline long ezTestDiff(const unsigned char* a, const unsigned char* b, const int width, const int height) {
+	long count = 0;
+
+	for (long i = 0; i < (long)width * height * 4; i++) {
+		count += a[i] != b[i];
+	}
+
+	return count;
+}
+
+// Writes a square image as a PPM file, with a pattern that depends on the seed,
+// so tests get images with different contents without any being shipped. Returns 0 if the file can't be written.
+static inline int ezTestWriteImage(const char* fileName, const int size, const int seed) {
+	FILE* file = fopen(fileName, "wb");
+
+	if (file == NULL) {
+		return 0;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", size, size);
+
+	for (int i = 0; i < size * size; i++) {
+		const unsigned char pixel[3] = { (unsigned char)(i * seed), (unsigned char)(255 - i), (unsigned char)(seed * 40) };
+		fwrite(pixel, 1, 3, file);
+	}
+
+	fclose(file);
+	return 1;
+}
+
+// Prints whether every check passed and exits with a matching status.
+// The library owns main, so this is the only way to hand the result back.
+static inline void ezTestFinish(void) {
+	if (g_ezTestFailures) {
+		printf("FAIL (%d checks failed)\n", g_ezTestFailures);
+	} else {
+		printf("PASS\n");
+	}
+
+	fflush(stdout);
+	exit(g_ezTestFailures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,112 @@
+//
+// Checks that ezDrawMany draws exactly what a loop of ezDraw calls does.
+// Overlapping objects alternate between two textures, so ezDrawMany reorders them to save batches.
+// Each pair of frames draws them both ways and compares what was drawn, first as they are, then with rounded corners
+// (which ezDrawMany keeps in order), then with borders.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 240
+#define TEST_OBJECTS 300
+// each case takes a frame drawn with ezDraw, then one with ezDrawMany
+#define TEST_CASES 3
+
+EZobject* objects[TEST_OBJECTS];
+unsigned char* pixels[2];
+int batches[2];
+int frame;
+
+int setup(void)
+{
+	ezDisplaySize(TEST_WIDTH, TEST_HEIGHT);
+	// each image gets a texture of its own, so objects using different ones can't share a batch
+	ezSetAtlasEnabled(0);
+
+	if (!ezTestWriteImage("test_drawmany_a.ppm", 16, 3) || !ezTestWriteImage("test_drawmany_b.ppm", 16, 5)) {
+		printf("Couldn't write the test images\n");
+		return 0;
+	}
+
+	const int a = ezLoadImage("test_drawmany_a.ppm");
+	const int b = ezLoadImage("test_drawmany_b.ppm");
+	remove("test_drawmany_a.ppm");
+	remove("test_drawmany_b.ppm");
+	srand(1);
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		objects[i] = ezCreateRect(10.0f + rand() % 40, 10.0f + rand() % 40);
+		ezMove(objects[i], rand() % TEST_WIDTH, rand() % TEST_HEIGHT);
+		ezColour(objects[i], (rand() % 256) / 255.0f, (rand() % 256) / 255.0f, (rand() % 256) / 255.0f);
+
+		if (i % 3) {
+			ezTexture(objects[i], i % 3 == 1 ? a : b);
+		}
+
+		if (i % 7 == 0) {
+			ezRotate(objects[i], i * 0.1f);
+		}
+	}
+
+	pixels[0] = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	pixels[1] = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	return pixels[0] && pixels[1] ? EZ_OK : 0;
+}
+
+void draw(void)
+{
+	const int testCase = frame / 2;
+	const int many = frame % 2;
+
+	// batches are counted once the frame is over, so this is the last frame's
+	if (frame > 0) {
+		EZframestats stats;
+		ezGetFrameStats(&stats);
+		batches[!many] = stats.batches;
+	}
+
+	if (frame > 0 && !many) {
+		char name[128];
+		sprintf(name, "case %d: ezDrawMany matches ezDraw", testCase);
+		ezTestCheck(ezTestDiff(pixels[0], pixels[1], TEST_WIDTH, TEST_HEIGHT) == 0, name);
+
+		if (testCase == 1) {
+			ezTestCheck(batches[1] < batches[0], "ezDrawMany took fewer batches for sharp edged objects");
+		}
+	}
+
+	if (testCase == TEST_CASES) {
+		ezTestFinish();
+	}
+
+	if (frame == 2) {
+		for (int i = 0; i < TEST_OBJECTS; i += 5) {
+			ezFilletRadius(objects[i], 6.0f);
+		}
+	} else if (frame == 4) {
+		for (int i = 0; i < TEST_OBJECTS; i += 5) {
+			ezFilletRadius(objects[i], 0.0f);
+			ezBorder(objects[i], 2.0f, 1.0f, 1.0f, 1.0f);
+		}
+	}
+
+	if (many) {
+		// split up, so the depths of one call have to stay behind those of the next
+		ezDrawMany(objects, 100);
+		ezDraw(objects[100]);
+		ezDrawMany(objects + 101, TEST_OBJECTS - 101);
+	} else {
+		for (int i = 0; i < TEST_OBJECTS; i++) {
+			ezDraw(objects[i]);
+		}
+	}
+
+	ezReadPixels(pixels[many]);
+	frame++;
+}
+
+void cleanup(void)
+{
+}
@@ -0,0 +1,66 @@
+//
+// Checks how many OpenGL calls a frame takes, going by ezGetFrameStats.
+// The vertex layout lives in a vertex array object and the state tracker skips anything already set,
+// so once the first frames are over, drawing more batches should only add draw calls, not state changes.
+// Pointing the instance attributes somewhere else counts as a state change per attribute, so a layout change
+// on every batch, as drivers without GL_ARB_base_instance need, fails the test.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 240
+// one batch's worth, then enough for several
+#define TEST_FEW_OBJECTS 1000
+#define TEST_MANY_OBJECTS 30000
+// frames to draw before counting, while shaders and buffers are still being set up
+#define TEST_WARMUP_FRAMES 5
+
+EZobject* objects[TEST_MANY_OBJECTS];
+int frame;
+EZframestats few;
+
+int setup(void)
+{
+	ezDisplaySize(TEST_WIDTH, TEST_HEIGHT);
+
+	for (int i = 0; i < TEST_MANY_OBJECTS; i++) {
+		objects[i] = ezCreateRect(4.0f, 4.0f);
+		ezMove(objects[i], i % TEST_WIDTH, (i / TEST_WIDTH) % TEST_HEIGHT);
+	}
+
+	return EZ_OK;
+}
+
+void draw(void)
+{
+	// the first few frames draw a few objects, the rest draw all of them
+	const int count = frame <= TEST_WARMUP_FRAMES ? TEST_FEW_OBJECTS : TEST_MANY_OBJECTS;
+
+	if (frame == TEST_WARMUP_FRAMES) {
+		ezGetFrameStats(&few);
+		printf("%d objects: %d batches, %d draw calls, %d state calls, %d elided\n",
+			TEST_FEW_OBJECTS, few.batches, few.drawCalls, few.stateCalls, few.elidedStateCalls);
+		ezTestCheck(few.batches == 1 && few.drawCalls == 1, "a batch's worth of objects takes one draw call");
+	} else if (frame == 2 * TEST_WARMUP_FRAMES) {
+		EZframestats many;
+		ezGetFrameStats(&many);
+		printf("%d objects: %d batches, %d draw calls, %d state calls, %d elided\n",
+			TEST_MANY_OBJECTS, many.batches, many.drawCalls, many.stateCalls, many.elidedStateCalls);
+		ezTestCheck(many.batches > 1 && many.drawCalls == many.batches, "each batch takes one draw call");
+		ezTestCheck(many.stateCalls <= few.stateCalls, "more batches don't take more state changes");
+		ezTestCheck(many.elidedStateCalls > few.elidedStateCalls, "the state of later batches is skipped");
+		ezTestFinish();
+	}
+
+	for (int i = 0; i < count; i++) {
+		ezDraw(objects[i]);
+	}
+
+	frame++;
+}
+
+void cleanup(void)
+{
+}
@@ -0,0 +1,151 @@
+//
+// Checks ezPick and ezPickAll against testing every object, and measures how many picks a second they manage.
+// The objects have anchors and rounded corners, a few are big enough to cover much of the window,
+// and some are deleted after they're drawn, which picking has to skip.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define TEST_WIDTH 1600
+#define TEST_HEIGHT 1000
+#define TEST_OBJECTS 100000
+#define TEST_POINTS 2000
+#define TEST_TIMED_PICKS 1000000
+
+EZobject* objects[TEST_OBJECTS];
+// each object's rectangle as set up: left, bottom, right, top
+float rects[TEST_OBJECTS][4];
+// and its corner radii, in the order ezCornerRadii takes them
+float radii[TEST_OBJECTS][4];
+int alive[TEST_OBJECTS];
+int frame;
+
+// Whether a point is inside an object, the slow way
+static int inside(const int i, const float x, const float y)
+{
+	const float* rect = rects[i];
+
+	if (x < rect[0] || x > rect[2] || y < rect[1] || y > rect[3]) {
+		return 0;
+	}
+
+	// the corner of the quarter the point is in, limited like the shader does
+	const int right = x * 2.0f > rect[0] + rect[2];
+	const int top = y * 2.0f > rect[1] + rect[3];
+	const float limit = fminf(rect[2] - rect[0], rect[3] - rect[1]) / 2.0f;
+	const float radius = fminf(radii[i][top ? (right ? 2 : 3) : (right ? 1 : 0)], limit);
+	const float dx = right ? x - (rect[2] - radius) : (rect[0] + radius) - x;
+	const float dy = top ? y - (rect[3] - radius) : (rect[1] + radius) - y;
+	return dx <= 0.0f || dy <= 0.0f || dx * dx + dy * dy <= radius * radius;
+}
+
+// Picks random points and compares the results with testing every object, topmost first
+static void check(const char* name)
+{
+	int mismatches = 0;
+
+	for (int point = 0; point < TEST_POINTS; point++) {
+		const float x = (rand() % (TEST_WIDTH * 8)) / 8.0f;
+		const float y = (rand() % (TEST_HEIGHT * 8)) / 8.0f;
+		int top = -1;
+		int count = 0;
+
+		for (int i = TEST_OBJECTS - 1; i >= 0; i--) {
+			if (alive[i] && inside(i, x, y)) {
+				if (top < 0) top = i;
+				count++;
+			}
+		}
+
+		EZobject* all[64];
+		EZobject* picked = ezPick(x, y);
+		const int found = ezPickAll(x, y, all, 64);
+
+		if (picked != (top < 0 ? NULL : objects[top]) || found != count || (found > 0 && all[0] != picked)) {
+			mismatches++;
+		}
+	}
+
+	printf("%s: %d of %d points mismatched\n", name, mismatches, TEST_POINTS);
+	ezTestCheck(mismatches == 0, name);
+}
+
+int setup(void)
+{
+	ezDisplaySize(TEST_WIDTH, TEST_HEIGHT);
+	srand(9);
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		const int big = i % 5000 == 0;
+		const float width = big ? 900.0f : 3.0f + rand() % 40;
+		const float height = big ? 700.0f : 3.0f + rand() % 40;
+		const float x = (float)(rand() % TEST_WIDTH);
+		const float y = (float)(rand() % TEST_HEIGHT);
+		const float anchorX = (rand() % 3) / 2.0f;
+		const float anchorY = (rand() % 3) / 2.0f;
+
+		for (int corner = 0; corner < 4; corner++) {
+			radii[i][corner] = i % 3 ? (float)(rand() % 25) : 0.0f;
+		}
+
+		objects[i] = ezCreateRect(width, height);
+		ezMove(objects[i], x, y);
+		ezAnchor(objects[i], anchorX, anchorY);
+		ezCornerRadii(objects[i], radii[i][0], radii[i][1], radii[i][2], radii[i][3]);
+		rects[i][0] = x - anchorX * width;
+		rects[i][1] = y - anchorY * height;
+		rects[i][2] = rects[i][0] + width;
+		rects[i][3] = rects[i][1] + height;
+		alive[i] = 1;
+	}
+
+	return EZ_OK;
+}
+
+void draw(void)
+{
+	// drawing is only recorded once the program has picked something
+	if (frame == 0) {
+		ezPick(0.0, 0.0);
+	} else if (frame == 2) {
+		check("picks match every object tested in turn");
+
+		// still drawn last frame, but gone now
+		for (int i = 10; i < TEST_OBJECTS; i += 1000) {
+			ezDelete(objects[i]);
+			alive[i] = 0;
+		}
+
+		check("deleted objects are skipped");
+	} else if (frame == 3) {
+		check("after the deleted objects are drawn no more");
+
+		const double start = ezTestTime();
+		uintptr_t sum = 0;
+
+		for (int i = 0; i < TEST_TIMED_PICKS; i++) {
+			sum += (uintptr_t)ezPick((i * 7919LL) % TEST_WIDTH + 0.5, (i * 104729LL) % TEST_HEIGHT + 0.5);
+		}
+
+		const double seconds = ezTestTime() - start;
+		// printed so the picks can't be optimised out
+		printf("%.0f picks per second, %.3f us each (%u)\n", TEST_TIMED_PICKS / seconds, seconds / TEST_TIMED_PICKS * 1e6, (unsigned int)(sum & 1));
+		ezTestFinish();
+	}
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		if (alive[i]) {
+			ezDraw(objects[i]);
+		}
+	}
+
+	frame++;
+}
+
+void cleanup(void)
+{
+}
@@ -0,0 +1,122 @@
+//
+// Checks that the scene draws the same as drawing its objects one by one, and only uploads what changed.
+// A few of the objects use images loaded in the background, which arrive one per frame.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 240
+#define TEST_OBJECTS 20000
+#define TEST_IMAGES 8
+#define TEST_MOVED 10
+// frames to draw the scene for, giving every image time to arrive
+#define TEST_SCENE_FRAMES 30
+
+EZobject* objects[TEST_OBJECTS];
+int images[TEST_IMAGES];
+unsigned char* pixels[2];
+int frame;
+int mostUploaded;
+
+// Draws the scene, then every object one by one on the next frame, and checks they came out the same
+static void compare(const char* name, const int step)
+{
+	if (step == 0) {
+		ezDrawScene();
+		ezReadPixels(pixels[0]);
+	} else {
+		for (int i = 0; i < TEST_OBJECTS; i++) {
+			ezDraw(objects[i]);
+		}
+
+		ezReadPixels(pixels[1]);
+		ezTestCheck(ezTestDiff(pixels[0], pixels[1], TEST_WIDTH, TEST_HEIGHT) == 0, name);
+	}
+}
+
+int setup(void)
+{
+	ezDisplaySize(TEST_WIDTH, TEST_HEIGHT);
+	// one image a frame, so each arrives on its own
+	ezSetImageUploadBudget(0.0);
+	srand(2);
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		objects[i] = ezCreateRect(4.0f + rand() % 10, 4.0f + rand() % 10);
+		ezMove(objects[i], rand() % TEST_WIDTH, rand() % TEST_HEIGHT);
+		ezColour(objects[i], (rand() % 256) / 255.0f, (rand() % 256) / 255.0f, 0.5f);
+		ezSceneAdd(objects[i]);
+	}
+
+	for (int i = 0; i < TEST_IMAGES; i++) {
+		char fileName[64];
+		sprintf(fileName, "test_scene_%d.ppm", i);
+
+		if (!ezTestWriteImage(fileName, 64, i + 2)) {
+			printf("Couldn't write the test images\n");
+			return 0;
+		}
+
+		images[i] = ezLoadImageAsync(fileName, NULL);
+		ezResize(objects[i * (TEST_OBJECTS / TEST_IMAGES)], 40.0f, 40.0f);
+		ezTexture(objects[i * (TEST_OBJECTS / TEST_IMAGES)], images[i]);
+	}
+
+	pixels[0] = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	pixels[1] = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	return pixels[0] && pixels[1] ? EZ_OK : 0;
+}
+
+void draw(void)
+{
+	EZscenestats stats;
+
+	if (frame < TEST_SCENE_FRAMES) {
+		// the first frame uploads everything
+		ezDrawScene();
+		ezGetSceneStats(&stats);
+
+		if (frame > 0 && stats.uploaded > mostUploaded) {
+			mostUploaded = stats.uploaded;
+		}
+	} else if (frame == TEST_SCENE_FRAMES) {
+		printf("most objects uploaded in a frame while images arrived: %d\n", mostUploaded);
+		ezTestCheck(mostUploaded == 1, "an image arriving only uploads the object using it");
+
+		for (int i = 0; i < TEST_IMAGES; i++) {
+			char fileName[64];
+			sprintf(fileName, "test_scene_%d.ppm", i);
+			remove(fileName);
+		}
+
+		compare("the scene matches drawing its objects one by one", 0);
+	} else if (frame == TEST_SCENE_FRAMES + 1) {
+		compare("the scene matches drawing its objects one by one", 1);
+	} else if (frame == TEST_SCENE_FRAMES + 2) {
+		for (int i = 0; i < TEST_MOVED; i++) {
+			ezMove(objects[i * 100], rand() % TEST_WIDTH, rand() % TEST_HEIGHT);
+		}
+
+		compare("after moving some objects", 0);
+		ezGetSceneStats(&stats);
+		ezTestCheck(stats.uploaded == TEST_MOVED, "moving some objects only uploads those");
+	} else if (frame == TEST_SCENE_FRAMES + 3) {
+		compare("after moving some objects", 1);
+	} else if (frame == TEST_SCENE_FRAMES + 4) {
+		ezFreeImage(images[0]);
+		compare("after freeing an image in use", 0);
+		ezGetSceneStats(&stats);
+		ezTestCheck(stats.uploaded == 1, "freeing an image only uploads the objects using it");
+	} else {
+		compare("after freeing an image in use", 1);
+		ezTestFinish();
+	}
+
+	frame++;
+}
+
+void cleanup(void)
+{
+}
@@ -0,0 +1,130 @@
+//
+// Compares the software renderer with OpenGL.
+// Each case is drawn by OpenGL on one frame and by the software renderer on the next, and the two readbacks
+// are compared. They can't match exactly, since the two sample textures and cover edge pixels slightly differently,
+// so the check is that only a few pixels are far apart.
+// See eztest.h for how to build and run it.
+//
+
+#include "eztest.h"
+
+#define TEST_WIDTH 400
+#define TEST_HEIGHT 300
+#define TEST_OBJECTS 500
+#define TEST_CASES 4
+// a channel further apart than this counts the pixel as different
+#define TEST_TOLERANCE 40
+// fraction of the window's pixels allowed to be different
+#define TEST_MAX_DIFFERENT 0.002
+
+EZobject* objects[TEST_OBJECTS];
+int image;
+unsigned char* pixels[2];
+int frame;
+
+static const char* caseNames[TEST_CASES] = {
+	"plain rectangles",
+	"rounded corners and borders",
+	"turned and stretched, through a turned camera",
+	"textured",
+};
+
+// Sets the objects up for a case
+static void setCase(const int testCase)
+{
+	srand(testCase + 1);
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		ezResize(objects[i], 5.0f + rand() % 40, 5.0f + rand() % 40);
+		ezMove(objects[i], rand() % (TEST_WIDTH + 40) - 20, rand() % (TEST_HEIGHT + 40) - 20);
+		ezColour(objects[i], (rand() % 256) / 255.0f, (rand() % 256) / 255.0f, (rand() % 256) / 255.0f);
+
+		if (testCase >= 1 && i % 2) {
+			ezFilletRadius(objects[i], (float)(rand() % 12));
+		}
+
+		if (testCase >= 1 && i % 5 == 0) {
+			ezBorder(objects[i], 2.0f, 1.0f, 1.0f, 1.0f);
+		}
+
+		if (testCase >= 2) {
+			ezRotate(objects[i], (rand() % 628) / 100.0f);
+			ezScale(objects[i], 0.5f + (rand() % 100) / 100.0f, 0.5f + (rand() % 100) / 100.0f);
+		}
+
+		if (testCase >= 3 && i % 3 == 0) {
+			ezTexture(objects[i], image);
+		}
+	}
+
+	if (testCase == 2) {
+		ezCameraRotate(0.3f);
+		ezCameraZoom(1.3f);
+	}
+}
+
+int setup(void)
+{
+	ezDisplaySize(TEST_WIDTH, TEST_HEIGHT);
+	// the software renderer needs its own copy of each image, which is only kept while it's chosen
+	ezSetRenderer(EZ_RENDERER_SOFTWARE);
+	image = ezLoadImage("maminonawa.png");
+	ezSetRenderer(EZ_RENDERER_OPENGL);
+
+	if (image == 0) {
+		printf("Couldn't load maminonawa.png. Run the test from the EzGraphix folder.\n");
+		return 0;
+	}
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		objects[i] = ezCreateRect(1.0f, 1.0f);
+	}
+
+	pixels[0] = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	pixels[1] = malloc(TEST_WIDTH * TEST_HEIGHT * 4);
+	return pixels[0] && pixels[1] ? EZ_OK : 0;
+}
+
+void draw(void)
+{
+	const int testCase = frame / 2;
+	const int software = frame % 2;
+
+	if (!software) {
+		setCase(testCase);
+	}
+
+	for (int i = 0; i < TEST_OBJECTS; i++) {
+		ezDraw(objects[i]);
+	}
+
+	ezReadPixels(pixels[software]);
+
+	if (software) {
+		long different = 0;
+
+		for (int i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++) {
+			for (int channel = 0; channel < 3; channel++) {
+				if (abs(pixels[0][i * 4 + channel] - pixels[1][i * 4 + channel]) > TEST_TOLERANCE) {
+					different++;
+					break;
+				}
+			}
+		}
+
+		printf("%s: %ld of %d pixels differ\n", caseNames[testCase], different, TEST_WIDTH * TEST_HEIGHT);
+		ezTestCheck(different <= TEST_MAX_DIFFERENT * TEST_WIDTH * TEST_HEIGHT, caseNames[testCase]);
+
+		if (testCase == TEST_CASES - 1) {
+			ezTestFinish();
+		}
+	}
+
+	// takes effect from the next frame
+	ezSetRenderer(software ? EZ_RENDERER_OPENGL : EZ_RENDERER_SOFTWARE);
+	frame++;
+}
+
+void cleanup(void)
+{
+}